@@ -0,0 +1,63 @@
+#-------------------------------------------------
+#
+# Benchmarks of the map editor. They are built with all the sources of
+# Engine.pro, except its main().
+#
+#-------------------------------------------------
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT       += core gui opengl network concurrent testlib
+
+win32{
+    LIBS += -lOpengl32
+}
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = Benchmarks
+
+TEMPLATE = app
+
+#-------------------------------------------------
+# Sources of the engine, read from Engine.pro
+#-------------------------------------------------
+
+ENGINE = $$PWD/..
+ENGINE_PRO = $$ENGINE/Engine.pro
+
+INCLUDEPATH += $$ENGINE
+ENGINE_INCLUDEPATH = $$fromfile($$ENGINE_PRO, INCLUDEPATH)
+for(path, ENGINE_INCLUDEPATH): INCLUDEPATH += $$ENGINE/$$path
+
+ENGINE_HEADERS = $$fromfile($$ENGINE_PRO, HEADERS)
+for(file, ENGINE_HEADERS): HEADERS += $$ENGINE/$$file
+
+ENGINE_SOURCES = $$fromfile($$ENGINE_PRO, SOURCES)
+for(file, ENGINE_SOURCES) {
+    !equals(file, main.cpp): SOURCES += $$ENGINE/$$file
+}
+
+ENGINE_FORMS = $$fromfile($$ENGINE_PRO, FORMS)
+for(file, ENGINE_FORMS): FORMS += $$ENGINE/$$file
+
+ENGINE_RESOURCES = $$fromfile($$ENGINE_PRO, RESOURCES)
+for(file, ENGINE_RESOURCES): RESOURCES += $$ENGINE/$$file
+
+#-------------------------------------------------
+# Benchmarks
+#-------------------------------------------------
+
+HEADERS += \
+    benchmapportion.h \
+    benchfloors.h \
+    benchstroke.h \
+    benchidle.h
+
+SOURCES += \
+    main.cpp \
+    benchmapportion.cpp \
+    benchfloors.cpp \
+    benchstroke.cpp \
+    benchidle.cpp
@@ -0,0 +1,237 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtTest>
+#include "benchfloors.h"
+#include "wanok.h"
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void BenchFloors::addRows() {
+    QTest::addColumn<bool>("isHash");
+    QTest::addColumn<int>("density");
+
+    QTest::newRow("hash 25%") << true << 25;
+    QTest::newRow("slices 25%") << false << 25;
+    QTest::newRow("hash 100%") << true << 100;
+    QTest::newRow("slices 100%") << false << 100;
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::getPositions(QList<Position>& positions, int density) {
+
+    // The same squares for each run, on two heights of the portion (0, 0)
+    for (int y = 0; y < 2; y++) {
+        for (int i = 0; i < Wanok::portionSize * Wanok::portionSize; i++) {
+            if ((i * 37) % 100 < density) {
+                positions.append(Position(i % Wanok::portionSize, y, 0,
+                                          i / Wanok::portionSize, 0));
+            }
+        }
+    }
+}
+
+// -------------------------------------------------------
+
+QRect BenchFloors::getTexture(int i) {
+    return QRect(i % 8, (i / 8) % 8, 1, 1);
+}
+
+// -------------------------------------------------------
+//
+//  SLOTS
+//
+// -------------------------------------------------------
+
+void BenchFloors::memory_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::memory() {
+    QFETCH(bool, isHash);
+    QFETCH(int, density);
+    QList<Position> positions;
+    getPositions(positions, density);
+    qint64 size;
+
+    // For the hash, one node (next, hash, key, value) per floor plus the
+    // buckets, and the heap FloorDatas and QRect of each floor
+    if (isHash) {
+        qint64 node = 2 * sizeof(void*) + sizeof(uint) + sizeof(Position);
+        size = positions.size() * (node + sizeof(FloorDatas) +
+                                   sizeof(QRect) + sizeof(void*));
+    }
+    else {
+        Portion globalPortion(0, 0, 0);
+        Floors floors(globalPortion);
+        for (int i = 0; i < positions.size(); i++)
+            floors.setFloor(positions[i], getTexture(i));
+        size = floors.memorySize();
+    }
+
+    qInfo().noquote() << QString(QTest::currentDataTag()) + ":" << size
+                      << "bytes for" << positions.size() << "floors";
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::fill_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::fill() {
+    QFETCH(bool, isHash);
+    QFETCH(int, density);
+    QList<Position> positions;
+    getPositions(positions, density);
+    Portion globalPortion(0, 0, 0);
+
+    if (isHash) {
+        QBENCHMARK {
+            FloorsHash floors;
+            for (int i = 0; i < positions.size(); i++) {
+                floors.insert(positions[i],
+                              new FloorDatas(new QRect(getTexture(i))));
+            }
+            qDeleteAll(floors);
+        }
+    }
+    else {
+        QBENCHMARK {
+            Floors floors(globalPortion);
+            for (int i = 0; i < positions.size(); i++)
+                floors.setFloor(positions[i], getTexture(i));
+        }
+    }
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::lookup_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::lookup() {
+    QFETCH(bool, isHash);
+    QFETCH(int, density);
+    QList<Position> positions, squares;
+    getPositions(positions, density);
+    getPositions(squares, 100);
+    Portion globalPortion(0, 0, 0);
+    QRect texture;
+    int found = 0;
+
+    // Every square is looked up, empty or not
+    if (isHash) {
+        FloorsHash floors;
+        for (int i = 0; i < positions.size(); i++) {
+            floors.insert(positions[i],
+                          new FloorDatas(new QRect(getTexture(i))));
+        }
+        QBENCHMARK {
+            found = 0;
+            for (int i = 0; i < squares.size(); i++) {
+                FloorDatas* floor = floors.value(squares[i]);
+                if (floor != nullptr) {
+                    texture = *floor->textureRect();
+                    found++;
+                }
+            }
+        }
+        qDeleteAll(floors);
+    }
+    else {
+        Floors floors(globalPortion);
+        for (int i = 0; i < positions.size(); i++)
+            floors.setFloor(positions[i], getTexture(i));
+        QBENCHMARK {
+            found = 0;
+            for (int i = 0; i < squares.size(); i++) {
+                if (floors.getLand(squares[i], texture) !=
+                    MapEditorSubSelectionKind::None)
+                {
+                    found++;
+                }
+            }
+        }
+    }
+
+    QCOMPARE(found, positions.size());
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::vertices_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchFloors::vertices() {
+    QFETCH(bool, isHash);
+    QFETCH(int, density);
+    QList<Position> positions;
+    getPositions(positions, density);
+    Portion globalPortion(0, 0, 0);
+    int squareSize = Wanok::BASIC_SQUARE_SIZE;
+    int width = 8 * squareSize, height = 8 * squareSize;
+
+    // The whole portion is built, as when it is loaded
+    if (isHash) {
+        FloorsHash floors;
+        for (int i = 0; i < positions.size(); i++) {
+            floors.insert(positions[i],
+                          new FloorDatas(new QRect(getTexture(i))));
+        }
+        QBENCHMARK {
+            QVector<MapPortionGeometry> geometries(Position::LAYERS_NUMBER);
+            for (FloorsHash::iterator i = floors.begin(); i != floors.end();
+                 i++)
+            {
+                Position p = i.key();
+                Floor::initializeVertices(geometries[p.layer()], squareSize,
+                                          width, height, p,
+                                          *i.value()->textureRect());
+            }
+        }
+        qDeleteAll(floors);
+    }
+    else {
+        Floors floors(globalPortion);
+        QHash<Position, MapElement*> previewSquares;
+        for (int i = 0; i < positions.size(); i++)
+            floors.setFloor(positions[i], getTexture(i));
+        QBENCHMARK {
+            MapPortionChunks chunks(globalPortion);
+            floors.initializeVertices(chunks, previewSquares, squareSize,
+                                      width, height);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHFLOORS_H
+#define BENCHFLOORS_H
+
+#include <QObject>
+#include "floors.h"
+
+// -------------------------------------------------------
+//
+//  CLASS BenchFloors
+//
+//  Compares the floors stored by height slices with a hash of heap
+//  FloorDatas keyed by Position, which is how the floors were stored
+//  before the slices. It measures the fill, the lookups, the vertices
+//  built, and prints the memory used.
+//
+// -------------------------------------------------------
+
+typedef QHash<Position, FloorDatas*> FloorsHash;
+
+class BenchFloors : public QObject
+{
+    Q_OBJECT
+protected:
+    static void addRows();
+    static void getPositions(QList<Position>& positions, int density);
+    static QRect getTexture(int i);
+
+private slots:
+    void memory_data();
+    void memory();
+    void fill_data();
+    void fill();
+    void lookup_data();
+    void lookup();
+    void vertices_data();
+    void vertices();
+};
+
+#endif // BENCHFLOORS_H
@@ -0,0 +1,147 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtTest>
+#include "benchidle.h"
+#include "wanok.h"
+#include "camera.h"
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+const int BenchIdle::IDLE_MSECS = 5000;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+BenchIdle::BenchIdle() :
+    m_project(nullptr),
+    m_widget(nullptr)
+{
+
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+qint64 BenchIdle::getCpuTime() {
+
+    // User and kernel time of all the threads, in milliseconds
+    #ifdef Q_OS_WIN
+        FILETIME creation, exited, kernel, user;
+        GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel,
+                        &user);
+        quint64 time = (((quint64) kernel.dwHighDateTime << 32) |
+                        kernel.dwLowDateTime) +
+                (((quint64) user.dwHighDateTime << 32) | user.dwLowDateTime);
+
+        return time / 10000;
+    #else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+                (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    #endif
+}
+
+// -------------------------------------------------------
+//
+//  SLOTS
+//
+// -------------------------------------------------------
+
+void BenchIdle::initTestCase() {
+    QString path = qgetenv("RPM_BENCH_PROJECT");
+    if (path.isEmpty())
+        QSKIP("RPM_BENCH_PROJECT is not set");
+
+    m_project = new Project;
+    Wanok::get()->setProject(m_project);
+    QVERIFY(m_project->read(path));
+
+    // Opened like a map of the tree, then waits for all its portions
+    m_widget = new WidgetMapEditor;
+    m_widget->resize(800, 600);
+    m_widget->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_widget));
+    m_widget->needUpdateMap(1, &m_position, &m_positionObject,
+                            Camera::defaultDistance, Camera::defaultHAngle,
+                            Camera::defaultVAngle);
+    QTRY_VERIFY_WITH_TIMEOUT(m_widget->getMap() != nullptr &&
+                             !m_widget->getMap()->isOpening() &&
+                             !m_widget->getMap()->isStreaming(), 60000);
+}
+
+// -------------------------------------------------------
+
+void BenchIdle::cleanupTestCase() {
+    if (m_widget != nullptr) {
+        m_widget->deleteMap();
+        m_project->setCurrentMap(nullptr);
+        delete m_widget;
+    }
+    Wanok::get()->setProject(nullptr);
+    delete m_project;
+}
+
+// -------------------------------------------------------
+
+void BenchIdle::idle_data() {
+    QTest::addColumn<bool>("isContinuous");
+
+    QTest::newRow("continuous") << true;
+    QTest::newRow("on demand") << false;
+}
+
+// -------------------------------------------------------
+
+void BenchIdle::idle() {
+    QFETCH(bool, isContinuous);
+    EngineSettings* settings = Wanok::get()->engineSettings();
+    bool previousContinuous = settings->continuousRendering();
+    settings->setContinuousRendering(isContinuous);
+
+    // The frames requested by the previous row are drawn first
+    m_widget->update();
+    QTest::qWait(500);
+
+    QElapsedTimer timer;
+    qint64 frames = m_widget->framesPainted();
+    qint64 cpuTime = getCpuTime();
+    timer.start();
+    QTest::qWait(IDLE_MSECS);
+    frames = m_widget->framesPainted() - frames;
+    cpuTime = getCpuTime() - cpuTime;
+    qint64 elapsed = timer.elapsed();
+
+    settings->setContinuousRendering(previousContinuous);
+    qInfo().noquote() << QString(QTest::currentDataTag()) + ":"
+                      << frames * 1000.0 / elapsed << "frames per second,"
+                      << cpuTime * 100.0 / elapsed << "% of a CPU";
+}
@@ -0,0 +1,62 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHIDLE_H
+#define BENCHIDLE_H
+
+#include <QObject>
+#include "widgetmapeditor.h"
+#include "project.h"
+
+// -------------------------------------------------------
+//
+//  CLASS BenchIdle
+//
+//  Measures what an idle map editor costs: the frames painted and the
+//  CPU time of the process while nothing happens, with and without the
+//  continuous rendering. The frames painted are also the work sent to
+//  the GPU, whose usage itself needs an external profiler. The map 1 of
+//  the project in the RPM_BENCH_PROJECT environment variable is opened,
+//  and the benchmark is skipped without it.
+//
+// -------------------------------------------------------
+
+class BenchIdle : public QObject
+{
+    Q_OBJECT
+public:
+    BenchIdle();
+    const static int IDLE_MSECS;
+
+protected:
+    Project* m_project;
+    WidgetMapEditor* m_widget;
+    QVector3D m_position;
+    QVector3D m_positionObject;
+
+    static qint64 getCpuTime();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void idle_data();
+    void idle();
+};
+
+#endif // BENCHIDLE_H
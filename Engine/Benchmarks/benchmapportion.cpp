@@ -0,0 +1,170 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtTest>
+#include <QJsonDocument>
+#include "benchmapportion.h"
+#include "wanok.h"
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void BenchMapPortion::fillPortion(MapPortion& portion, int density) {
+    Portion globalPortion;
+    portion.getGlobalPortion(globalPortion);
+    int originX = globalPortion.x() * Wanok::portionSize;
+    int originZ = globalPortion.z() * Wanok::portionSize;
+    QSet<Portion> portionsOverflow;
+
+    // The same squares for each run, with the textures of a 8x8 tileset
+    for (int i = 0; i < Wanok::portionSize * Wanok::portionSize; i++) {
+        if ((i * 37) % 100 >= density)
+            continue;
+        Position position(originX + i % Wanok::portionSize, 0, 0,
+                          originZ + i / Wanok::portionSize, 0);
+        portion.addLand(position,
+                        new FloorDatas(new QRect(i % 8, (i / 8) % 8, 1, 1)));
+
+        // A sprite on a square out of four
+        if (i % 4 == 0) {
+            portion.addSprite(portionsOverflow, position,
+                              MapEditorSubSelectionKind::SpritesFace, 50, 0,
+                              QRect((i / 4) % 4 * 2, 0, 2, 2));
+        }
+    }
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::addRows() {
+    QTest::addColumn<bool>("isBinary");
+    QTest::addColumn<int>("density");
+
+    QTest::newRow("json 25%") << false << 25;
+    QTest::newRow("binary 25%") << true << 25;
+    QTest::newRow("json 100%") << false << 100;
+    QTest::newRow("binary 100%") << true << 100;
+}
+
+// -------------------------------------------------------
+
+QByteArray BenchMapPortion::writePortion(const MapPortion& portion,
+                                         bool isBinary)
+{
+    QByteArray data;
+
+    // Same as Wanok::writeJSON and Wanok::writeBinary, without the file
+    if (isBinary)
+        Wanok::writeBinaryData(data, portion);
+    else {
+        QJsonObject json;
+        portion.write(json);
+        data = QJsonDocument(json).toJson(QJsonDocument::Compact);
+    }
+
+    return data;
+}
+
+// -------------------------------------------------------
+
+bool BenchMapPortion::readPortion(const QByteArray& data, bool isBinary,
+                                  MapPortion& portion)
+{
+    if (isBinary)
+        return Wanok::readBinaryData(data, portion);
+
+    QJsonDocument document = QJsonDocument::fromJson(data);
+    portion.read(document.object());
+
+    return !document.isNull();
+}
+
+// -------------------------------------------------------
+//
+//  SLOTS
+//
+// -------------------------------------------------------
+
+void BenchMapPortion::size_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::size() {
+    QFETCH(bool, isBinary);
+    QFETCH(int, density);
+    Portion globalPortion(0, 0, 0);
+    MapPortion portion(globalPortion);
+    fillPortion(portion, density);
+    QByteArray data = writePortion(portion, isBinary);
+
+    qInfo().noquote() << QString(QTest::currentDataTag()) + ":"
+                      << data.size() << "bytes per portion";
+
+    // The portion read gives a file of the same size
+    MapPortion portionRead(globalPortion);
+    QVERIFY(readPortion(data, isBinary, portionRead));
+    QCOMPARE(writePortion(portionRead, isBinary).size(), data.size());
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::write_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::write() {
+    QFETCH(bool, isBinary);
+    QFETCH(int, density);
+    Portion globalPortion(0, 0, 0);
+    MapPortion portion(globalPortion);
+    fillPortion(portion, density);
+
+    QBENCHMARK {
+        writePortion(portion, isBinary);
+    }
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::read_data() {
+    addRows();
+}
+
+// -------------------------------------------------------
+
+void BenchMapPortion::read() {
+    QFETCH(bool, isBinary);
+    QFETCH(int, density);
+    Portion globalPortion(0, 0, 0);
+    MapPortion portion(globalPortion);
+    fillPortion(portion, density);
+    QByteArray data = writePortion(portion, isBinary);
+
+    QBENCHMARK {
+        MapPortion portionRead(globalPortion);
+        readPortion(data, isBinary, portionRead);
+    }
+}
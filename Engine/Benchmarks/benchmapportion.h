@@ -0,0 +1,57 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMAPPORTION_H
+#define BENCHMAPPORTION_H
+
+#include <QObject>
+#include "mapportion.h"
+
+// -------------------------------------------------------
+//
+//  CLASS BenchMapPortion
+//
+//  Compares the json and binary formats of a portion: the bytes of a
+//  file, and the time to write and to read it. The portions are filled
+//  with floors and face sprites at several densities.
+//
+// -------------------------------------------------------
+
+class BenchMapPortion : public QObject
+{
+    Q_OBJECT
+public:
+    static void fillPortion(MapPortion& portion, int density);
+
+protected:
+    static void addRows();
+    static QByteArray writePortion(const MapPortion& portion, bool isBinary);
+    static bool readPortion(const QByteArray& data, bool isBinary,
+                            MapPortion& portion);
+
+private slots:
+    void size_data();
+    void size();
+    void write_data();
+    void write();
+    void read_data();
+    void read();
+};
+
+#endif // BENCHMAPPORTION_H
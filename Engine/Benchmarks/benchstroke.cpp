@@ -0,0 +1,69 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtTest>
+#include "benchstroke.h"
+#include "benchmapportion.h"
+#include "wanok.h"
+
+// -------------------------------------------------------
+//
+//  SLOTS
+//
+// -------------------------------------------------------
+
+void BenchStroke::stroke_data() {
+    QTest::addColumn<bool>("isFull");
+
+    QTest::newRow("full") << true;
+    QTest::newRow("chunks") << false;
+}
+
+// -------------------------------------------------------
+
+void BenchStroke::stroke() {
+    QFETCH(bool, isFull);
+    Portion globalPortion(0, 0, 0);
+    MapPortion portion(globalPortion);
+    MapTexture tileset(QImage(8 * Wanok::BASIC_SQUARE_SIZE,
+                              8 * Wanok::BASIC_SQUARE_SIZE,
+                              QImage::Format_ARGB32));
+    QHash<int, MapTexture*> characters, walls;
+    MapTextureAtlas atlas;
+    int squareSize = Wanok::BASIC_SQUARE_SIZE;
+    BenchMapPortion::fillPortion(portion, 100);
+    portion.initializeVertices(squareSize, &tileset, characters, walls, atlas);
+
+    // A row across the middle of the portion, one square after the other
+    int z = Wanok::portionSize / 2;
+    QBENCHMARK {
+        for (int x = 0; x < Wanok::portionSize; x++) {
+            Position position(x, 0, 0, z, 0);
+            portion.addLand(position, new FloorDatas(new QRect(x % 8, 0, 1,
+                                                               1)));
+
+            // Marks every chunk as dirty, like the portion updates did
+            // before the chunks
+            if (isFull)
+                portion.updateSpriteWalls();
+            portion.initializeVertices(squareSize, &tileset, characters,
+                                       walls, atlas);
+        }
+    }
+}
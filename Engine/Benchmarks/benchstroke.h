@@ -0,0 +1,46 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHSTROKE_H
+#define BENCHSTROKE_H
+
+#include <QObject>
+#include "mapportion.h"
+
+// -------------------------------------------------------
+//
+//  CLASS BenchStroke
+//
+//  Measures the latency of a brush stroke on a dense portion: a floor
+//  is drawn on each square of a row, and the vertices of the portion
+//  are built after each of them, as Map::updatePortion does. The
+//  chunked rebuild is compared with a rebuild of the whole portion.
+//  The upload to the GPU is not included.
+//
+// -------------------------------------------------------
+
+class BenchStroke : public QObject
+{
+    Q_OBJECT
+private slots:
+    void stroke_data();
+    void stroke();
+};
+
+#endif // BENCHSTROKE_H
@@ -0,0 +1,51 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QApplication>
+#include <QtTest>
+#include "benchmapportion.h"
+#include "benchfloors.h"
+#include "benchstroke.h"
+#include "benchidle.h"
+
+//-------------------------------------------------
+//
+//  MAIN
+//
+//  Runs all the benchmarks. The arguments are the ones of QTest, for
+//  example -iterations 100 or -tickcounter.
+//
+//-------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    int result = 0;
+
+    BenchMapPortion benchMapPortion;
+    result |= QTest::qExec(&benchMapPortion, argc, argv);
+    BenchFloors benchFloors;
+    result |= QTest::qExec(&benchFloors, argc, argv);
+    BenchStroke benchStroke;
+    result |= QTest::qExec(&benchStroke, argc, argv);
+    BenchIdle benchIdle;
+    result |= QTest::qExec(&benchIdle, argc, argv);
+
+    return result;
+}
@@ -203,9 +203,27 @@ void ControlExport::removeMapsTemp(QString pathDatas){
 
     while (directories.hasNext()){
         directories.next();
-        QDir(Wanok::pathCombine(Wanok::pathCombine(pathMaps,
-                                                   directories.fileName()),
-                                "temp")).removeRecursively();
+        QString pathMap = Wanok::pathCombine(pathMaps, directories.fileName());
+        QDir(Wanok::pathCombine(pathMap, "temp")).removeRecursively();
+
+        // Binary portions are only read by the engine
+        QFile(Wanok::pathCombine(pathMap, Wanok::FILE_MAP_PACK)).remove();
+        QFile(Wanok::pathCombine(pathMap, Wanok::FILE_MAP_JOURNAL)).remove();
+        QStringList filters("*." + Wanok::EXTENSION_PORTION_BINARY);
+        QDirIterator files(pathMap, filters, QDir::Files);
+        while (files.hasNext())
+            QFile(files.next()).remove();
+
+        // Empty portions of older projects: the game handles missing files
+        QDirIterator portions(pathMap, QStringList("*_*_*.json"), QDir::Files);
+        while (portions.hasNext()) {
+            QFile portion(portions.next());
+            if (portion.size() <= 2 && portion.open(QIODevice::ReadOnly) &&
+                portion.readAll() == "{}")
+            {
+                portion.remove();
+            }
+        }
     }
 }
 
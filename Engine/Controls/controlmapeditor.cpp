@@ -22,8 +22,13 @@
 #include "wanok.h"
 #include "qbox3d.h"
 #include <QTime>
+#include <QDebug>
+#include <QtMath>
 #include <math.h>
 
+const int ControlMapEditor::PREFETCH_TIME = 500;
+const int ControlMapEditor::PREFETCH_SAMPLE_TIME = 100;
+
 // -------------------------------------------------------
 //
 //  CONSTRUCTOR / DESTRUCTOR / GET / SET
@@ -42,7 +47,11 @@ ControlMapEditor::ControlMapEditor() :
     m_displayGrid(true),
     m_treeMapNode(nullptr),
     m_isDrawingWall(false),
-    m_isDeletingWall(false)
+    m_isDeletingWall(false),
+    m_isStrokeEnded(false),
+    m_strokeUpdates(0),
+    m_strokeTime(0),
+    m_strokeTimeMax(0)
 {
 
 }
@@ -88,6 +97,8 @@ void ControlMapEditor::moveCursorToMousePosition(QPoint point)
 // -------------------------------------------------------
 
 void ControlMapEditor::reLoadTextures(){
+
+    // Only the pictures whose file changed are decoded again
     m_map->loadTextures();
 }
 
@@ -101,13 +112,17 @@ Map* ControlMapEditor::loadMap(int idMap, QVector3D* position,
     clearPortionsToUpdate();
 
     // Map & cursor
-    m_map = new Map(idMap);
+    m_map = new Map(idMap, &m_texturesCache);
     Wanok::get()->project()->setCurrentMap(m_map);
     m_map->initializeCursor(position);
     m_map->initializeGL();
     // Update current portion and load all the local portions
     m_currentPortion = cursor()->getPortion();
     m_map->loadPortions(m_currentPortion);
+    m_cursorPreviousPosition = QVector3D(cursor()->getX(), cursor()->getY(),
+                                         cursor()->getZ());
+    m_cursorVelocity = QVector3D();
+    m_cursorTimer.start();
 
     // Grid
     m_grid = new Grid;
@@ -217,9 +232,12 @@ void ControlMapEditor::update(MapEditorSubSelectionKind subSelection) {
 
     // Update portions
     updatePortions(subSelection);
+    if (m_isStrokeEnded)
+        logStroke();
     saveTempPortions();
     clearPortionsToUpdate();
     updateMovingPortions();
+    m_map->updateLoadedPortions();
 
     // Camera
     m_camera->update(cursor(), m_map->squareSize());
@@ -666,11 +684,7 @@ void ControlMapEditor::updatePreviewOthers(
         }
         switch (selection) {
         case MapEditorSelectionKind::Sprites:
-            element = new SpriteDatas(subSelection, 50, 0,
-                                     new QRect(tileset.x(),
-                                                tileset.y(),
-                                                tileset.width(),
-                                                tileset.height()));
+            element = new SpriteDatas(subSelection, 50, 0, tileset);
             break;
         default:
             break;
@@ -689,6 +703,10 @@ void ControlMapEditor::updatePreviewElement(Position &p, Portion& portion,
                                             MapElement* element)
 {
     MapPortion* mapPortion = m_map->mapPortion(portion);
+    if (mapPortion == nullptr) {
+        delete element;
+        return;
+    }
     mapPortion->addPreview(p, element);
     m_portionsToUpdate += mapPortion;
     m_portionsPreviousPreview += mapPortion;
@@ -701,6 +719,10 @@ void ControlMapEditor::updatePreviewElementGrid(GridPosition& p,
                                                 MapElement* element)
 {
     MapPortion* mapPortion = m_map->mapPortion(portion);
+    if (mapPortion == nullptr) {
+        delete element;
+        return;
+    }
     if (element == nullptr)
         mapPortion->addPreviewDeleteGrid(p);
     else
@@ -718,7 +740,29 @@ void ControlMapEditor::updatePortions(MapEditorSubSelectionKind subSelection) {
         if (subSelection == MapEditorSubSelectionKind::SpritesWall)
             mapPortion->updateSpriteWalls();
         m_map->updatePortion(mapPortion);
+
+        // Latency of the current brush stroke
+        m_strokeUpdates++;
+        m_strokeTime += m_map->updatePortionTime();
+        m_strokeTimeMax = qMax(m_strokeTimeMax, m_map->updatePortionTime());
+    }
+}
+
+// -------------------------------------------------------
+
+void ControlMapEditor::logStroke() {
+    if (m_isStrokeEnded && m_strokeUpdates > 0 &&
+        Wanok::get()->engineSettings()->showStatistics())
+    {
+        qInfo().noquote() << "Map editor: stroke of" << m_strokeUpdates
+                          << "portion updates, total"
+                          << m_strokeTime / 1000000.0 << "ms, max"
+                          << m_strokeTimeMax / 1000000.0 << "ms";
     }
+    m_isStrokeEnded = false;
+    m_strokeUpdates = 0;
+    m_strokeTime = 0;
+    m_strokeTimeMax = 0;
 }
 
 // -------------------------------------------------------
@@ -729,101 +773,105 @@ void ControlMapEditor::updateMovingPortions() {
     updateMovingPortionsEastWest(newPortion);
     updateMovingPortionsNorthSouth(newPortion);
     updateMovingPortionsUpDown(newPortion);
-
-    m_currentPortion = newPortion;
+    updatePrefetchPortions();
 }
 
 // -------------------------------------------------------
 
 void ControlMapEditor::updateMovingPortionsEastWest(Portion& newPortion){
-    int r = m_map->portionsRay();
-    if (newPortion.x() > m_currentPortion.x()) {
-        int k = 0;
-        for (int j = -r; j <= r; j++) {
-            bool visible = j != -r && j != r;
-            int i = -r;
-            removePortion(i, k, j);
-            setPortion(i, k, j, i + 1, k, j, false);
-            i++;
-            for (; i < r; i++)
-                setPortion(i, k, j, i + 1, k, j, visible);
-
-            loadPortion(newPortion, r, k, j);
-        }
-    }
-    else if (newPortion.x() < m_currentPortion.x()) {
-        int k = 0;
-        for (int j = -r; j <= r; j++) {
-            bool visible = j != -r && j != r;
-            int i = r;
-            removePortion(i, k, j);
-            setPortion(i, k, j, i - 1, k, j, false);
-            i--;
-            for (; i > -r; i--)
-                setPortion(i, k, j, i - 1, k, j, visible);
-
-            loadPortion(newPortion, -r, k, j);
-        }
-    }
+    while (newPortion.x() != m_currentPortion.x())
+        moveWindow(newPortion.x() > m_currentPortion.x() ? 1 : -1, 0, 0);
 }
 
 // -------------------------------------------------------
 
 void ControlMapEditor::updateMovingPortionsNorthSouth(Portion& newPortion){
-    int r = m_map->portionsRay();
-    if (newPortion.z() > m_currentPortion.z()) {
-        int k = 0;
-        for (int i = -r; i <= r; i++) {
-            bool visible = i != -r && i != r;
-            int j = -r;
-            removePortion(i, k, j);
-            setPortion(i, k, j, i, k, j + 1, false);
-            j++;
-            for (; j < r; j++)
-                setPortion(i, k, j, i, k, j + 1, visible);
-
-            loadPortion(newPortion, i, k, r);
-        }
-    }
-    else if (newPortion.z() < m_currentPortion.z()) {
-        int k = 0;
-        for (int i = -r; i <= r; i++) {
-            bool visible = i != -r && i != r;
-            int j = r;
-            removePortion(i, k, j);
-            setPortion(i, k, j, i, k, j - 1, false);
-            j--;
-            for (; j > -r; j--)
-                setPortion(i, k, j, i, k, j - 1, visible);
-
-            loadPortion(newPortion, i, k, -r);
-        }
-    }
+    while (newPortion.z() != m_currentPortion.z())
+        moveWindow(0, 0, newPortion.z() > m_currentPortion.z() ? 1 : -1);
 }
 
 // -------------------------------------------------------
 
-void ControlMapEditor::updateMovingPortionsUpDown(Portion&){
-    // TODO
+void ControlMapEditor::updateMovingPortionsUpDown(Portion& newPortion){
+    while (newPortion.y() != m_currentPortion.y())
+        moveWindow(0, newPortion.y() > m_currentPortion.y() ? 1 : -1, 0);
 }
 
 // -------------------------------------------------------
 
-void ControlMapEditor::removePortion(int i, int j, int k){
-    MapPortion* mapPortion = m_map->mapPortion(i, j, k);
-    if (mapPortion != nullptr)
-        delete mapPortion;
+void ControlMapEditor::moveWindow(int x, int y, int z) {
+    QList<Portion> portions;
+    m_currentPortion.addX(x);
+    m_currentPortion.addY(y);
+    m_currentPortion.addZ(z);
+    m_map->setPortionsOrigin(m_currentPortion);
+
+    // The slab leaving the window shares its slots with the entering one
+    getSlab(x, y, z, m_map->portionsRay(), portions);
+    for (int i = 0; i < portions.size(); i++) {
+        const Portion& portion = portions.at(i);
+        removePortion(portion.x(), portion.y(), portion.z());
+        loadPortion(m_currentPortion, portion.x(), portion.y(), portion.z());
+    }
 }
 
 // -------------------------------------------------------
 
-void ControlMapEditor::setPortion(int i, int j, int k, int m, int n, int o,
-                                  bool visible)
+void ControlMapEditor::getSlab(int x, int y, int z, int distance,
+                               QList<Portion>& portions) const
 {
-    Portion previousPortion(i, j, k);
-    Portion newPortion(m, n, o);
+    int r = m_map->portionsRay();
+    for (int a = -r; a <= r; a++) {
+        for (int b = -r; b <= r; b++) {
+            portions.append(Portion(x != 0 ? x * distance : a,
+                                    y != 0 ? y * distance : (x != 0 ? a : b),
+                                    z != 0 ? z * distance : b));
+        }
+    }
+}
+
+// -------------------------------------------------------
+
+void ControlMapEditor::updatePrefetchPortions() {
+    QVector3D position(cursor()->getX(), cursor()->getY(), cursor()->getZ());
+    qint64 elapsed = m_cursorTimer.elapsed();
+    int depth = Wanok::get()->engineSettings()->prefetchDepth();
+    int r = m_map->portionsRay();
+
+    // The frames are not painted at a fixed rate: the velocity, in squares
+    // per second, is measured over PREFETCH_SAMPLE_TIME at least
+    if (elapsed >= PREFETCH_SAMPLE_TIME) {
+        m_cursorVelocity = (position - m_cursorPreviousPosition) * 1000.0f /
+                (elapsed * m_map->squareSize());
+        m_cursorPreviousPosition = position;
+        m_cursorTimer.restart();
+    }
+
+    // Slabs reached by the cursor within PREFETCH_TIME
+    for (int axis = 0; axis < 3 && depth > 0; axis++) {
+        float speed = m_cursorVelocity[axis];
+        if (qFuzzyIsNull(speed))
+            continue;
+        int d = speed > 0 ? 1 : -1;
+        int slabs = qBound(1, qCeil(qAbs(speed) * PREFETCH_TIME /
+                                    (1000.0f * Wanok::portionSize)), depth);
+        for (int s = 1; s <= slabs; s++) {
+            QList<Portion> portions;
+            getSlab(axis == 0 ? d : 0, axis == 1 ? d : 0, axis == 2 ? d : 0,
+                    r + s, portions);
+            for (int i = 0; i < portions.size(); i++) {
+                Portion portion = m_currentPortion;
+                portion += portions.at(i);
+                m_map->prefetchPortion(portion);
+            }
+        }
+    }
+}
+
+// -------------------------------------------------------
 
-    m_map->replacePortion(previousPortion, newPortion, visible);
+void ControlMapEditor::removePortion(int i, int j, int k){
+    m_map->evictPortion(i, j, k);
 }
 
 // -------------------------------------------------------
@@ -832,7 +880,7 @@ void ControlMapEditor::loadPortion(Portion& currentPortion, int i, int j,
                                    int k)
 {
     m_map->loadPortion(currentPortion.x() + i, currentPortion.y() + j,
-                       currentPortion.z() + k, i, j, k, false);
+                       currentPortion.z() + k, i, j, k);
 }
 
 // -------------------------------------------------------
@@ -1026,14 +1074,9 @@ void ControlMapEditor::paintPinLand(Position& p,
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
         if (m_map->isInPortion(portion)){
-            LandDatas* landBefore = getLand(portion, p);
-            MapEditorSubSelectionKind kindBefore =
-                    MapEditorSubSelectionKind::None;
             QRect textureBefore;
-            if (landBefore != nullptr){
-                kindBefore = landBefore->getSubKind();
-                getLandTexture(textureBefore, landBefore);
-            }
+            MapEditorSubSelectionKind kindBefore = getLand(portion, p,
+                                                           textureBefore);
 
             // If it's floor, we need to reduce to square * square size texture
             QRect textureAfterReduced;
@@ -1041,7 +1084,9 @@ void ControlMapEditor::paintPinLand(Position& p,
                 getFloorTextureReduced(textureAfter, textureAfterReduced, 0, 0);
 
             // If the texture à different, start the algorithm
-            if (!areLandsEquals(landBefore, textureAfterReduced, kindAfter)){
+            if (!areLandsEquals(kindBefore, textureBefore,
+                                textureAfterReduced, kindAfter))
+            {
                 QList<Position> tab;
                 tab.push_back(p);
                 if (kindAfter == MapEditorSubSelectionKind::None)
@@ -1075,10 +1120,12 @@ void ControlMapEditor::paintPinLand(Position& p,
                         if (m_map->isInGrid(adjacentPosition)){
                             portion = m_map->getLocalPortion(adjacentPosition);
                             if (m_map->isInPortion(portion)){
-                                LandDatas* landHere = getLand(portion,
-                                                              adjacentPosition);
-                                if (areLandsEquals(landHere, textureBefore,
-                                                   kindBefore))
+                                QRect textureHere;
+                                MapEditorSubSelectionKind kindHere =
+                                        getLand(portion, adjacentPosition,
+                                                textureHere);
+                                if (areLandsEquals(kindHere, textureHere,
+                                                   textureBefore, kindBefore))
                                 {
                                     if (kindAfter ==
                                             MapEditorSubSelectionKind::None)
@@ -1101,11 +1148,14 @@ void ControlMapEditor::paintPinLand(Position& p,
 
 // -------------------------------------------------------
 
-LandDatas* ControlMapEditor::getLand(Portion& portion, Position& p){
+MapEditorSubSelectionKind ControlMapEditor::getLand(Portion& portion,
+                                                    Position& p,
+                                                    QRect& texture)
+{
     MapPortion* mapPortion = m_map->mapPortion(portion);
     if (mapPortion == nullptr)
-        return nullptr;
-    return mapPortion->getLand(p);
+        return MapEditorSubSelectionKind::None;
+    return mapPortion->getLand(p, texture);
 }
 
 // -------------------------------------------------------
@@ -1121,18 +1171,18 @@ void ControlMapEditor::getFloorTextureReduced(QRect& rect, QRect &rectAfter,
 
 // -------------------------------------------------------
 
-bool ControlMapEditor::areLandsEquals(LandDatas* landBefore,
+bool ControlMapEditor::areLandsEquals(MapEditorSubSelectionKind kindBefore,
+                                      QRect& textureBefore,
                                       QRect& textureAfter,
                                       MapEditorSubSelectionKind kindAfter)
 {
-    if (landBefore == nullptr)
+    if (kindBefore == MapEditorSubSelectionKind::None)
         return kindAfter == MapEditorSubSelectionKind::None;
     else{
-        if (landBefore->getSubKind() == kindAfter){
+        if (kindBefore == kindAfter){
             switch (kindAfter){
             case MapEditorSubSelectionKind::Floors:
-                return (*(((FloorDatas*) landBefore)->textureRect())) ==
-                        textureAfter;
+                return textureBefore == textureAfter;
             case MapEditorSubSelectionKind::Autotiles:
                 return false; // TODO
             case MapEditorSubSelectionKind::Water:
@@ -1169,33 +1219,13 @@ LandDatas* ControlMapEditor::getLandAfter(MapEditorSubSelectionKind kindAfter,
 
 // -------------------------------------------------------
 
-void ControlMapEditor::getLandTexture(QRect& rect, LandDatas* land){
-    FloorDatas* floor;
-
-    switch (land->getSubKind()) {
-    case MapEditorSubSelectionKind::Floors:
-        floor = (FloorDatas*) land;
-        rect.setX(floor->textureRect()->x());
-        rect.setY(floor->textureRect()->y());
-        rect.setWidth(floor->textureRect()->width());
-        rect.setHeight(floor->textureRect()->height());
-        break;
-    case MapEditorSubSelectionKind::Autotiles:
-        break;
-    case MapEditorSubSelectionKind::Water:
-        break;
-    default:
-        break;
-    }
-}
-
-// -------------------------------------------------------
-
 void ControlMapEditor::stockLand(Position& p, LandDatas *landDatas){
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+
+        // Portions still loading can't be edited
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             if (mapPortion->addLand(p, landDatas) && m_map->saved())
                 setToNotSaved();
             m_portionsToUpdate += mapPortion;
@@ -1236,8 +1266,8 @@ void ControlMapEditor::removeLand(Position& p, DrawKind drawKind) {
 void ControlMapEditor::eraseLand(Position& p){
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             if (mapPortion->deleteLand(p) && m_map->saved())
                 setToNotSaved();
             m_portionsToUpdate += mapPortion;
@@ -1264,8 +1294,8 @@ void ControlMapEditor::addSprite(Position& p,
     case DrawKind::Pencil:
         traceLine(m_previousMouseCoords, p, positions);
         for (int i = 0; i < positions.size(); i++)
-            stockSprite(positions[i], kind, 50, 0, new QRect(tileset));
-        stockSprite(p, kind, 50, 0, new QRect(tileset));
+            stockSprite(positions[i], kind, 50, 0, tileset);
+        stockSprite(p, kind, 50, 0, tileset);
         break;
     case DrawKind::Pin:
         break;
@@ -1300,12 +1330,12 @@ void ControlMapEditor::addSpriteWall(DrawKind drawKind, int specialID) {
 
 void ControlMapEditor::stockSprite(Position& p, MapEditorSubSelectionKind kind,
                                    int widthPosition, int angle,
-                                   QRect *textureRect)
+                                   QRect& textureRect)
 {
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             QSet<Portion> portionsOverflow;
             if (mapPortion->addSprite(portionsOverflow, p, kind, widthPosition,
                                       angle, textureRect) &&
@@ -1318,12 +1348,8 @@ void ControlMapEditor::stockSprite(Position& p, MapEditorSubSelectionKind kind,
             m_portionsToSave += mapPortion;
             m_needMapInfosToSave = true;
             updatePortionsToSaveOverflow(portionsOverflow);
-
-            return;
         }
     }
-
-    delete textureRect;
 }
 
 // -------------------------------------------------------
@@ -1333,8 +1359,8 @@ void ControlMapEditor::stockSpriteWall(GridPosition& gridPosition,
 {
     if (m_map->isVisibleGridPosition(gridPosition)) {
         Portion portion = m_map->getPortionGrid(gridPosition);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             if (mapPortion->addSpriteWall(gridPosition, specialID) &&
                 m_map->saved())
             {
@@ -1392,8 +1418,8 @@ void ControlMapEditor::removeSpriteWall(DrawKind drawKind) {
 void ControlMapEditor::eraseSprite(Position& p){
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             QSet<Portion> portionsOverflow;
             if (mapPortion->deleteSprite(portionsOverflow, p) && m_map->saved())
                 setToNotSaved();
@@ -1411,8 +1437,8 @@ void ControlMapEditor::eraseSprite(Position& p){
 void ControlMapEditor::eraseSpriteWall(GridPosition& gridPosition) {
     if (m_map->isVisibleGridPosition(gridPosition)) {
         Portion portion = m_map->getPortionGrid(gridPosition);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             if (mapPortion->deleteSpriteWall(gridPosition) && m_map->saved())
             {
                 setToNotSaved();
@@ -1491,8 +1517,8 @@ void ControlMapEditor::addObject(Position& p){
     DialogObject dialog(object);
     int result = dialog.exec();
     Wanok::isInConfig = false;
-    if (result == QDialog::Accepted){
-        MapPortion* mapPortion = m_map->mapPortion(portion);
+    MapPortion* mapPortion = m_map->mapPortion(portion);
+    if (result == QDialog::Accepted && mapPortion != nullptr){
         if (m_map->addObject(p, mapPortion, object) &&
             m_map->saved())
         {
@@ -1511,10 +1537,10 @@ void ControlMapEditor::addObject(Position& p){
 void ControlMapEditor::removeObject(Position& p){
     if (m_map->isInGrid(p)){
         Portion portion = m_map->getLocalPortion(p);
-        if (m_map->isInPortion(portion)){
-            MapPortion* mapPortion = m_map->mapPortion(portion);
+        MapPortion* mapPortion = m_map->mapPortion(portion);
+        if (m_map->isInPortion(portion) && mapPortion != nullptr) {
             MapObjects* mapObjects = m_map->objectsPortion(portion);
-            SystemCommonObject* object;
+            SystemCommonObject* object = nullptr;
             if (mapObjects != nullptr)
                 object = mapObjects->getObjectAt(p);
 
@@ -1755,6 +1781,7 @@ void ControlMapEditor::paintGL(QMatrix4x4 &modelviewProjection,
                                MapEditorSubSelectionKind subSelectionKind,
                                DrawKind drawKind)
 {
+    m_map->updateVisiblePortions(modelviewProjection);
     m_map->paintFloors(modelviewProjection);
 
     if (selectionKind == MapEditorSelectionKind::Objects)
@@ -1819,6 +1846,10 @@ void ControlMapEditor::onMousePressed(MapEditorSelectionKind selection,
                                       QPoint point,
                                       Qt::MouseButton button)
 {
+    // The previews updated before the stroke are not part of it
+    m_isStrokeEnded = false;
+    logStroke();
+
     // Update mouse
     updateMouse(point);
 
@@ -1862,6 +1893,9 @@ void ControlMapEditor::onMouseReleased(MapEditorSelectionKind,
             removeSpriteWall(drawKind);
         }
     }
+
+    // Logged after the next update, which builds the walls drawn
+    m_isStrokeEnded = true;
 }
 
 // -------------------------------------------------------
@@ -21,6 +21,7 @@
 #define CONTROLMAPEDITOR_H
 
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include "map.h"
 #include "grid.h"
 #include "camera.h"
@@ -45,6 +46,8 @@ class ControlMapEditor
 public:
     ControlMapEditor();
     virtual ~ControlMapEditor();
+    const static int PREFETCH_TIME;
+    const static int PREFETCH_SAMPLE_TIME;
     Map* map() const;
     Grid* grid() const;
     Cursor* cursor() const;
@@ -102,11 +105,15 @@ public:
     void updateMovingPortions();
     void updateMovingPortionsEastWest(Portion& newPortion);
     void updateMovingPortionsNorthSouth(Portion& newPortion);
-    void updateMovingPortionsUpDown(Portion&);
+    void updateMovingPortionsUpDown(Portion& newPortion);
+    void moveWindow(int x, int y, int z);
+    void getSlab(int x, int y, int z, int distance,
+                 QList<Portion>& portions) const;
+    void updatePrefetchPortions();
     void removePortion(int i, int j, int k);
-    void setPortion(int i, int j, int k, int m, int n, int o, bool visible);
     void loadPortion(Portion& currentPortion, int i, int j, int k);
     void updatePortions(MapEditorSubSelectionKind subSelection);
+    void logStroke();
     void saveTempPortions();
     void clearPortionsToUpdate();
     void setToNotSaved();
@@ -130,15 +137,15 @@ public:
                   DrawKind drawKind, QRect& tileset, int);
     void paintPinLand(Position& p, MapEditorSubSelectionKind kindAfter,
                       QRect &textureAfter);
-    LandDatas* getLand(Portion& portion, Position& p);
+    MapEditorSubSelectionKind getLand(Portion& portion, Position& p,
+                                      QRect& texture);
     void getFloorTextureReduced(QRect &rect, QRect& rectAfter,
                                 int localX, int localZ);
-    bool areLandsEquals(LandDatas* landBefore,
-                        QRect &textureAfter,
+    bool areLandsEquals(MapEditorSubSelectionKind kindBefore,
+                        QRect& textureBefore, QRect &textureAfter,
                         MapEditorSubSelectionKind kindAfter);
     LandDatas* getLandAfter(MapEditorSubSelectionKind kindAfter,
                             QRect &textureAfter);
-    void getLandTexture(QRect& rect, LandDatas* land);
     void stockLand(Position& p, LandDatas* landDatas);
     void removeLand(Position& p, DrawKind drawKind);
     void eraseLand(Position& p);
@@ -146,7 +153,7 @@ public:
                    DrawKind drawKind, QRect& tileset);
     void addSpriteWall(DrawKind drawKind, int specialID);
     void stockSprite(Position& p, MapEditorSubSelectionKind kind,
-                     int widthPosition, int angle, QRect* textureRect);
+                     int widthPosition, int angle, QRect& textureRect);
     void stockSpriteWall(GridPosition& gridPosition, int specialID);
     void removeSprite(Position& p, DrawKind drawKind);
     void removeSpriteWall(DrawKind drawKind);
@@ -194,6 +201,9 @@ private:
     Cursor* m_cursorObject;
     Camera* m_camera;
 
+    // Textures shared by the maps, living with the GL context of the editor
+    MapTextureCache m_texturesCache;
+
     // Others
     int m_width;
     int m_height;
@@ -211,6 +221,9 @@ private:
     bool m_isGridOnTop;
     Position m_previousMouseCoords;
     Portion m_currentPortion;
+    QVector3D m_cursorPreviousPosition;
+    QVector3D m_cursorVelocity;
+    QElapsedTimer m_cursorTimer;
     QSet<MapPortion*> m_portionsToUpdate;
     QSet<MapPortion*> m_portionsToSave;
     bool m_needMapInfosToSave;
@@ -220,6 +233,12 @@ private:
     ContextMenuList* m_contextMenu;
     bool m_isDrawingWall;
     bool m_isDeletingWall;
+
+    // Statistics of the current brush stroke, in nanoseconds
+    bool m_isStrokeEnded;
+    int m_strokeUpdates;
+    qint64 m_strokeTime;
+    qint64 m_strokeTimeMax;
 };
 
 #endif // CONTROLMAPEDITOR_H
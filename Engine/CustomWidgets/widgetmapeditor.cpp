@@ -22,6 +22,7 @@
 #include <QHash>
 #include <QHashIterator>
 #include <QTime>
+#include <QPainter>
 #include "widgetmapeditor.h"
 #include "wanok.h"
 
@@ -39,23 +40,34 @@ WidgetMapEditor::WidgetMapEditor(QWidget *parent) :
     m_timerFirstPressure(new QTimer),
     m_firstPressure(false),
     m_spinBoxX(nullptr),
-    m_spinBoxZ(nullptr)
+    m_spinBoxZ(nullptr),
+    m_timerAnimation(new QTimer),
+    m_framesCount(0),
+    m_framesPerSecond(0),
+    m_framesPainted(0)
 {
     // Timers
     m_timerFirstPressure->setSingleShot(true);
     connect(m_timerFirstPressure, SIGNAL(timeout()),
             this, SLOT(onFirstPressure()));
+    m_timerAnimation->setSingleShot(true);
+    connect(m_timerAnimation, SIGNAL(timeout()), this, SLOT(update()));
+
+    // The mouse position is needed for the previews without any button
+    setMouseTracking(true);
 
     m_contextMenu = ContextMenuList::createContextObject(this);
     m_control.setContextMenu(m_contextMenu);
 
     m_elapsedTime = QTime::currentTime().msecsSinceStartOfDay();
+    m_framesTime = m_elapsedTime;
 }
 
 WidgetMapEditor::~WidgetMapEditor()
 {
     makeCurrent();
     delete m_timerFirstPressure;
+    delete m_timerAnimation;
 }
 
 void WidgetMapEditor::setMenuBar(WidgetMenuBarMapEditor* m){ m_menuBar = m; }
@@ -68,6 +80,8 @@ void WidgetMapEditor::setTreeMapNode(QStandardItem* item) {
 
 Map* WidgetMapEditor::getMap() const { return m_control.map(); }
 
+qint64 WidgetMapEditor::framesPainted() const { return m_framesPainted; }
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
@@ -95,6 +109,7 @@ Map *WidgetMapEditor::loadMap(int idMap, QVector3D* position,
 void WidgetMapEditor::deleteMap(){
     makeCurrent();
     m_control.deleteMap();
+    update();
 }
 
 // -------------------------------------------------------
@@ -110,15 +125,11 @@ void WidgetMapEditor::initializeGL(){
 
     // Initialize OpenGL Backend
     initializeOpenGLFunctions();
-    connect(this, SIGNAL(frameSwapped()), this, SLOT(update()));
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
 
     // Set global information
     //glCullFace(GL_FRONT_AND_BACK);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
-    glEnable( GL_BLEND );
-    glBlendEquation( GL_FUNC_ADD );
-    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+    initializeGLStates();
     /*
     glEnable(GL_ALPHA_TEST);
     glAlphaFunc(GL_GREATER, 0);
@@ -131,6 +142,16 @@ void WidgetMapEditor::initializeGL(){
 
 // -------------------------------------------------------
 
+void WidgetMapEditor::initializeGLStates(){
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glEnable( GL_BLEND );
+    glBlendEquation( GL_FUNC_ADD );
+    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+}
+
+// -------------------------------------------------------
+
 void WidgetMapEditor::resizeGL(int width, int height){
     m_control.onResize(width, height);
 }
@@ -139,6 +160,10 @@ void WidgetMapEditor::resizeGL(int width, int height){
 
 void WidgetMapEditor::paintGL(){
 
+    // The QPainter of the overlays disables depth test and blending at the
+    // end of the previous frame
+    initializeGLStates();
+
     // Clear buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -204,12 +229,76 @@ void WidgetMapEditor::paintGL(){
         m_control.paintGL(modelviewProjection, cameraRightWorldSpace,
                           cameraUpWorldSpace, kind, subKind, drawKind);
 
+        // Portions are still coming in after opening the map
+        if (m_control.map()->isOpening())
+            paintOpeningProgress(m_control.map()->openingProgress());
+        if (Wanok::get()->engineSettings()->showStatistics())
+            paintStatistics();
+
         m_elapsedTime = QTime::currentTime().msecsSinceStartOfDay();
+
+        // Frames drawn during the last second at least. When idle, the
+        // period is as long as the editor didn't paint anything
+        m_framesCount++;
+        m_framesPainted++;
+        if (m_elapsedTime - m_framesTime >= 1000) {
+            m_framesPerSecond = m_framesCount * 1000.0 /
+                    (m_elapsedTime - m_framesTime);
+            m_framesCount = 0;
+            m_framesTime = m_elapsedTime;
+        }
     }
 }
 
 // -------------------------------------------------------
 
+void WidgetMapEditor::paintOpeningProgress(int progress) {
+    QPainter painter(this);
+    int barWidth = width() - 20;
+    int barY = height() - 16;
+
+    painter.fillRect(QRect(10, barY, barWidth, 6), QColor(0, 0, 0, 120));
+    painter.fillRect(QRect(10, barY, barWidth * progress / 100, 6),
+                     QColor(255, 255, 255, 200));
+    painter.setPen(Qt::white);
+    painter.drawText(10, barY - 6, "Loading map... " +
+                     QString::number(progress) + "%");
+}
+
+// -------------------------------------------------------
+
+void WidgetMapEditor::paintStatistics() {
+    QPainter painter(this);
+    Map* map = m_control.map();
+
+    painter.setPen(Qt::white);
+    painter.drawText(10, 20, "Portions: " +
+                     QString::number(map->portionsDrawn()) + " drawn, " +
+                     QString::number(map->portionsCulled()) + " culled");
+    painter.drawText(10, 36, "Frames: " +
+                     QString::number(m_framesPerSecond, 'f', 1) +
+                     " per second, " + QString::number(m_framesPainted) +
+                     " painted");
+    painter.drawText(10, 52, "Last portion update: " +
+                     QString::number(map->updatePortionTime() / 1000000.0,
+                                     'f', 3) + " ms");
+}
+
+// -------------------------------------------------------
+
+bool WidgetMapEditor::needsRedraw() const {
+    if (Wanok::get()->engineSettings()->continuousRendering())
+        return true;
+
+    // Held keys move the cursor, and the streamed portions are uploaded
+    // a few at a time
+    Map* map = m_control.map();
+
+    return map != nullptr && (!m_keysPressed.isEmpty() || map->isStreaming());
+}
+
+// -------------------------------------------------------
+
 void WidgetMapEditor::update(){
     QOpenGLWidget::update();
 }
@@ -246,6 +335,7 @@ void WidgetMapEditor::initializeMap(){
     m_needUpdateMap = false;
     this->setFocus();
     updateSpinBoxes();
+    update();
 }
 
 // -------------------------------------------------------
@@ -257,27 +347,35 @@ void WidgetMapEditor::save(){
 // -------------------------------------------------------
 
 void WidgetMapEditor::setCursorX(int x){
-    if (m_control.map() != nullptr)
+    if (m_control.map() != nullptr) {
         m_control.cursor()->setX(x);
+        update();
+    }
 }
 
 void WidgetMapEditor::setCursorY(int y){
-    if (m_control.map() != nullptr)
+    if (m_control.map() != nullptr) {
         m_control.cursor()->setY(y);
+        update();
+    }
 }
 
 // -------------------------------------------------------
 
 void WidgetMapEditor::setCursorYplus(int yPlus){
-    if (m_control.map() != nullptr)
+    if (m_control.map() != nullptr) {
         m_control.cursor()->setYplus(yPlus);
+        update();
+    }
 }
 
 // -------------------------------------------------------
 
 void WidgetMapEditor::setCursorZ(int z){
-    if (m_control.map() != nullptr)
+    if (m_control.map() != nullptr) {
         m_control.cursor()->setZ(z);
+        update();
+    }
 }
 
 // -------------------------------------------------------
@@ -317,12 +415,14 @@ void WidgetMapEditor::deleteObject(){
     Position p;
     setObjectPosition(p);
     m_control.removeObject(p);
+    update();
 }
 
 // -------------------------------------------------------
 
 void WidgetMapEditor::removePreviewElements() {
     m_control.removePreviewElements();
+    update();
 }
 
 // -------------------------------------------------------
@@ -335,6 +435,7 @@ void WidgetMapEditor::focusOutEvent(QFocusEvent*){
     m_keysPressed.clear();
     m_mousesPressed.clear();
     this->setFocus();
+    update();
 }
 
 // -------------------------------------------------------
@@ -342,6 +443,7 @@ void WidgetMapEditor::focusOutEvent(QFocusEvent*){
 void WidgetMapEditor::wheelEvent(QWheelEvent* event){
     if (m_control.map() != nullptr){
         m_control.onMouseWheelMove(event);
+        update();
     }
 }
 
@@ -369,6 +471,7 @@ void WidgetMapEditor::mouseMoveEvent(QMouseEvent* event){
                                     button == Qt::MouseButton::LeftButton);
             }
         }
+        update();
     }
 }
 
@@ -400,6 +503,7 @@ void WidgetMapEditor::mousePressEvent(QMouseEvent* event){
                 m_control.update(MapEditorSubSelectionKind::None);
             }
         }
+        update();
     }
 }
 
@@ -417,6 +521,7 @@ void WidgetMapEditor::mouseReleaseEvent(QMouseEvent* event){
         m_control.onMouseReleased(m_menuBar->selectionKind(),
                                   subSelection, m_menuBar->drawKind(),
                                   tileset, specialID, event->pos(), button);
+        update();
     }
 }
 
@@ -430,6 +535,7 @@ void WidgetMapEditor::mouseDoubleClickEvent(QMouseEvent* event){
             if (m_menuBar->selectionKind() == MapEditorSelectionKind::Objects)
                 addObject();
         }
+        update();
     }
 }
 
@@ -490,6 +596,7 @@ void WidgetMapEditor::keyPressEvent(QKeyEvent* event){
             }
         }
         m_keysPressed += event->key();
+        update();
     }
 }
 
@@ -501,6 +608,7 @@ void WidgetMapEditor::keyReleaseEvent(QKeyEvent* event){
             m_keysPressed -= event->key();
             m_control.onKeyReleased(event->key());
         }
+        update();
     }
 }
 
@@ -512,6 +620,22 @@ void WidgetMapEditor::onFirstPressure(){
 
 // -------------------------------------------------------
 
+void WidgetMapEditor::onFrameSwapped() {
+    if (needsRedraw()) {
+        update();
+        return;
+    }
+
+    // Idle: only wake up for the next frame of the cursor animation
+    if (m_control.map() != nullptr) {
+        int msecs = m_control.cursor()->msecsToNextFrame();
+        if (msecs >= 0)
+            m_timerAnimation->start(msecs);
+    }
+}
+
+// -------------------------------------------------------
+
 void WidgetMapEditor::onKeyPress(int k, double speed){
     m_control.onKeyPressed(k, speed);
     updateSpinBoxes();
@@ -555,4 +679,5 @@ void WidgetMapEditor::contextDelete(){
 
 void WidgetMapEditor::contextHero(){
     m_control.defineAsHero();
+    update();
 }
@@ -33,7 +33,9 @@
 //
 //  CLASS WidgetMapEditor
 //
-//  A widget where the 3D map editor is drawn.
+//  A widget where the 3D map editor is drawn. A frame is only drawn
+//  after an input, a change of the map, or for the cursor animation,
+//  unless the continuous rendering is enabled in the engine settings.
 //
 // -------------------------------------------------------
 
@@ -54,7 +56,11 @@ public:
     void initializeSpinBoxesCoords(QSpinBox* x, QSpinBox* z);
     void resizeGL(int width, int height);
     void initializeGL();
+    void initializeGLStates();
     void paintGL();
+    void paintOpeningProgress(int progress);
+    void paintStatistics();
+    bool needsRedraw() const;
     void needUpdateMap(int idMap, QVector3D *position,
                        QVector3D *positionObject, int cameraDistance,
                        double cameraHorizontalAngle,
@@ -67,6 +73,7 @@ public:
     void setCursorYplus(int yPlus);
     void setCursorZ(int z);
     Map* getMap() const;
+    qint64 framesPainted() const;
     void updateSpinBoxes();
     void setObjectPosition(Position& position);
     void addObject();
@@ -93,10 +100,16 @@ private:
     double m_cameraVerticalAngle;
     ContextMenuList* m_contextMenu;
     long m_elapsedTime;
+    QTimer* m_timerAnimation;
+    int m_framesCount;
+    double m_framesPerSecond;
+    long m_framesTime;
+    qint64 m_framesPainted;
 
 public slots:
     void update();
     void onFirstPressure();
+    void onFrameSwapped();
 
 protected slots:
     void focusOutEvent(QFocusEvent*);
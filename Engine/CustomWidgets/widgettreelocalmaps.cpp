@@ -178,6 +178,7 @@ void WidgetTreeLocalMaps::updateNodesSaved(QStandardItem* item){
 // -------------------------------------------------------
 
 void WidgetTreeLocalMaps::deleteAllMapTemp(){
+    MapPortionWriter::get()->flush();
     QString pathMaps = Wanok::pathCombine(Wanok::get()->project()
                                           ->pathCurrentProject(),
                                           Wanok::pathMaps);
@@ -492,11 +493,20 @@ void WidgetTreeLocalMaps::contextEditMap(){
 
         DialogMapProperties dialog(properties);
         if (dialog.exec() == QDialog::Accepted){
-            QString pathTemp = Wanok::pathCombine(path,
-                                                  Wanok::TEMP_MAP_FOLDER_NAME);
+
+            // The opened map can't read its pack while the files are
+            // corrected: it is closed here, and reopened by showMap. Any
+            // other map is only corrected through its journal
+            Map* map = Wanok::get()->project()->currentMap();
+            bool isOpened = map != nullptr &&
+                    map->mapProperties()->id() == properties.id();
+            if (isOpened) {
+                m_widgetMapEditor->deleteMap();
+                if (m_project != nullptr)
+                    m_project->setCurrentMap(nullptr);
+            }
             if (Wanok::mapsToSave.contains(properties.id())) {
-                Wanok::copyAllFiles(pathTemp, path);
-                Wanok::deleteAllFiles(pathTemp);
+                Map::saveTemp(path);
                 Wanok::mapsToSave.remove(properties.id());
             }
             properties.save(path);
@@ -504,10 +514,12 @@ void WidgetTreeLocalMaps::contextEditMap(){
             Map::correctMap(path, previousProperties, properties);
             TreeMapDatas::setName(selected, properties.name());
             Wanok::get()->project()->writeTreeMapDatas();
-            showMap(selected);
+            if (isOpened) {
+                showMap(selected);
 
-            // Loading tileset texture
-            updateTileset();
+                // Loading tileset texture
+                updateTileset();
+            }
         }
     }
 }
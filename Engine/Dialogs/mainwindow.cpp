@@ -86,6 +86,7 @@ MainWindow::~MainWindow()
     delete gameProcess;
     gameProcess = nullptr;
     Wanok::kill();
+    MapPortionWriter::kill();
 }
 
 QString MainWindow::appName() const{ return p_appName; }
@@ -321,8 +322,7 @@ void MainWindow::on_actionBrowse_triggered(){
 // -------------------------------------------------------
 
 void MainWindow::on_actionSave_triggered(){
-    if (project->currentMap() != nullptr){
-        project->saveCurrentMap();
+    if (project->currentMap() != nullptr && project->saveCurrentMap()){
         Wanok::mapsToSave.remove(project->currentMap()->mapProperties()->id());
         ((PanelProject*)mainPanel)->widgetMapEditor()->save();
     }
@@ -6,7 +6,7 @@
 
 CONFIG += c++11
 
-QT       += core gui opengl network
+QT       += core gui opengl network concurrent
 
 win32{
     LIBS += -lOpengl32
@@ -229,7 +229,21 @@ HEADERS += \
     MathUtils/qplane3d.h \
     MathUtils/qray3d.h \
     MathUtils/smallqt3d_global.h \
-    MathUtils/qbox3d.h
+    MathUtils/qbox3d.h \
+    Models/binaryserializable.h \
+    MapEditor/mappack.h \
+    MapEditor/mapportionwriter.h \
+    MapEditor/mapjournal.h \
+    MapEditor/mapelementpool.h \
+    MapEditor/mapportionloader.h \
+    MapEditor/mapportioncache.h \
+    MapEditor/maptexture.h \
+    MapEditor/maptexturecache.h \
+    Models/projectsaver.h \
+    Enums/mapportionrangekind.h \
+    MapEditor/mapportionbuffer.h \
+    MapEditor/maptextureatlas.h \
+    MapEditor/mapportionchunks.h
 
 SOURCES += \
     main.cpp \
@@ -405,7 +419,19 @@ SOURCES += \
     Models/System/systemspecialelement.cpp \
     MathUtils/qplane3d.cpp \
     MathUtils/qray3d.cpp \
-    MathUtils/qbox3d.cpp
+    MathUtils/qbox3d.cpp \
+    Models/binaryserializable.cpp \
+    MapEditor/mappack.cpp \
+    MapEditor/mapportionwriter.cpp \
+    MapEditor/mapjournal.cpp \
+    MapEditor/mapportionloader.cpp \
+    MapEditor/mapportioncache.cpp \
+    MapEditor/maptexture.cpp \
+    MapEditor/maptexturecache.cpp \
+    Models/projectsaver.cpp \
+    MapEditor/mapportionbuffer.cpp \
+    MapEditor/maptextureatlas.cpp \
+    MapEditor/mapportionchunks.cpp
 
 FORMS += \
     Dialogs/mainwindow.ui \
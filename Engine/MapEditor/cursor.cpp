@@ -282,6 +282,16 @@ void Cursor::initializeGL(){
 
 // -------------------------------------------------------
 
+int Cursor::msecsToNextFrame() const {
+    if (m_frameNumber <= 1)
+        return -1;
+
+    return m_frameDuration - QTime::currentTime().msecsSinceStartOfDay() %
+            m_frameDuration;
+}
+
+// -------------------------------------------------------
+
 void Cursor::paintGL(QMatrix4x4 &modelviewProjection){
 
     // Calculating frame
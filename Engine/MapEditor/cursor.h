@@ -63,6 +63,7 @@ public:
     void initializeVertices();
     void initializeSquareSize(int s);
     void initialize();
+    int msecsToNextFrame() const;
     void paintGL(QMatrix4x4& modelviewProjection);
     void onKeyPressed(int key, double angle, int w, int h, double speed);
 
@@ -19,6 +19,7 @@
 
 #include "floors.h"
 #include "map.h"
+#include "wanok.h"
 
 // -------------------------------------------------------
 //
@@ -63,27 +64,55 @@ MapEditorSubSelectionKind FloorDatas::getSubKind() const{
 //
 // -------------------------------------------------------
 
-void FloorDatas::read(const QJsonObject & json){
+void FloorDatas::readTexture(const QJsonObject &json, QRect& texture){
     QJsonArray tab = json["t"].toArray();
 
-    m_textureRect->setLeft(tab[0].toInt());
-    m_textureRect->setTop(tab[1].toInt());
-    m_textureRect->setWidth(tab[2].toInt());
-    m_textureRect->setHeight(tab[3].toInt());
+    texture.setLeft(tab[0].toInt());
+    texture.setTop(tab[1].toInt());
+    texture.setWidth(tab[2].toInt());
+    texture.setHeight(tab[3].toInt());
 }
 
 // -------------------------------------------------------
 
-void FloorDatas::write(QJsonObject &json) const{
+void FloorDatas::writeTexture(QJsonObject &json, const QRect& texture){
     QJsonArray tab;
 
-    tab.append(m_textureRect->left());
-    tab.append(m_textureRect->top());
-    tab.append(m_textureRect->width());
-    tab.append(m_textureRect->height());
+    tab.append(texture.left());
+    tab.append(texture.top());
+    tab.append(texture.width());
+    tab.append(texture.height());
     json["t"] = tab;
 }
 
+// -------------------------------------------------------
+
+void FloorDatas::read(const QJsonObject & json){
+    readTexture(json, *m_textureRect);
+}
+
+// -------------------------------------------------------
+
+void FloorDatas::write(QJsonObject &json) const{
+    writeTexture(json, *m_textureRect);
+}
+
+// -------------------------------------------------------
+
+void FloorDatas::readBinary(QDataStream& stream, const BinaryPalette& palette){
+    quint32 textureIndex;
+
+    stream >> textureIndex;
+    *m_textureRect = palette.rect(textureIndex);
+}
+
+// -------------------------------------------------------
+
+void FloorDatas::writeBinary(QDataStream& stream, BinaryPalette& palette) const
+{
+    stream << palette.rectIndex(*m_textureRect);
+}
+
 // -------------------------------------------------------
 //
 //
@@ -107,96 +136,131 @@ int Floor::nbIndexesQuad(6);
 
 // -------------------------------------------------------
 //
-//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//  GL
 //
 // -------------------------------------------------------
 
-Floor::Floor() :
-    m_vertexBuffer(QOpenGLBuffer::VertexBuffer),
-    m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-    m_programStatic(nullptr)
+void Floor::initializeVertices(MapPortionGeometry& geometry, int squareSize,
+                               int width, int height, Position3D &p,
+                               const QRect& texture)
 {
+    QVector3D pos(p.x() * squareSize, 0.0f, p.z() * squareSize);
+    QVector3D size(squareSize, 0.0, squareSize);
+
+    float x = (float)(texture.x() * squareSize) / width;
+    float y = (float)(texture.y() * squareSize) / height;
+    float w = (float)(texture.width() * squareSize) / width;
+    float h = (float)(texture.height() * squareSize) / height;
+    float coefX = 0.1 / width;
+    float coefY = 0.1 / height;
+    x += coefX;
+    y += coefY;
+    w -= (coefX * 2);
+    h -= (coefY * 2);
+
+    // Vertices
+    geometry.verticesStatic.append(Vertex(Floor::verticesQuad[0] * size + pos,
+                                          QVector2D(x, y)));
+    geometry.verticesStatic.append(Vertex(Floor::verticesQuad[1] * size + pos,
+                                          QVector2D(x + w, y)));
+    geometry.verticesStatic.append(Vertex(Floor::verticesQuad[2] * size + pos,
+                                          QVector2D(x + w, y + h)));
+    geometry.verticesStatic.append(Vertex(Floor::verticesQuad[3] * size + pos,
+                                          QVector2D(x, y + h)));
+
+    // indexes
+    int offset = geometry.countStatic * Floor::nbVerticesQuad;
+    for (int i = 0; i < Floor::nbIndexesQuad; i++)
+        geometry.indexesStatic.append(Floor::indexesQuad[i] + offset);
 
+    geometry.countStatic++;
 }
 
-Floor::~Floor()
+// -------------------------------------------------------
+//
+//
+//  ---------- FLOORSSLICE
+//
+//
+// -------------------------------------------------------
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+FloorsSlice::FloorsSlice(int y, int yPlus) :
+    m_y(y),
+    m_yPlus(yPlus),
+    m_count(0),
+    m_occupied(size()),
+    m_textures(size())
 {
 
 }
 
+int FloorsSlice::y() const { return m_y; }
+
+int FloorsSlice::yPlus() const { return m_yPlus; }
+
+int FloorsSlice::count() const { return m_count; }
+
+int FloorsSlice::size() {
+    return Wanok::portionSize * Wanok::portionSize * Position::LAYERS_NUMBER;
+}
+
 // -------------------------------------------------------
 //
-//  GL
+//  INTERMEDIARY FUNCTIONS
 //
 // -------------------------------------------------------
 
-void Floor::clearGL(){
-    m_vertices.clear();
-    m_indexes.clear();
-    m_count = 0;
+int FloorsSlice::index(int x, int z, int layer) {
+    return (layer * Wanok::portionSize + z) * Wanok::portionSize + x;
 }
 
 // -------------------------------------------------------
 
-void Floor::initializeVertices(int squareSize, int width, int height,
-                               Position3D &p, FloorDatas *floor)
-{
-    QVector3D pos(p.x() * squareSize, 0.0f, p.z() * squareSize);
-    QVector3D size(squareSize, 0.0, squareSize);
+void FloorsSlice::coords(int index, int& x, int& z, int& layer) {
+    x = index % Wanok::portionSize;
+    index /= Wanok::portionSize;
+    z = index % Wanok::portionSize;
+    layer = index / Wanok::portionSize;
+}
 
-    float x = (float)(floor->textureRect()->x() * squareSize) / width;
-    float y = (float)(floor->textureRect()->y() * squareSize) / height;
-    float w = (float)(floor->textureRect()->width() * squareSize) / width;
-    float h = (float)(floor->textureRect()->height() * squareSize) / height;
-    float coefX = 0.1 / width;
-    float coefY = 0.1 / height;
-    x += coefX;
-    y += coefY;
-    w -= (coefX * 2);
-    h -= (coefY * 2);
+// -------------------------------------------------------
 
-    // Vertices
-    m_vertices.append(Vertex(Floor::verticesQuad[0] * size + pos,
-                      QVector2D(x, y)));
-    m_vertices.append(Vertex(Floor::verticesQuad[1] * size + pos,
-                      QVector2D(x + w, y)));
-    m_vertices.append(Vertex(Floor::verticesQuad[2] * size + pos,
-                      QVector2D(x + w, y + h)));
-    m_vertices.append(Vertex(Floor::verticesQuad[3] * size + pos,
-                      QVector2D(x, y + h)));
+bool FloorsSlice::isOccupied(int index) const {
+    return m_occupied.testBit(index);
+}
 
-    // indexes
-    int offset = m_count * Floor::nbVerticesQuad;
-    for (int i = 0; i < Floor::nbIndexesQuad; i++)
-        m_indexes.append(Floor::indexesQuad[i] + offset);
+// -------------------------------------------------------
 
-    m_count++;
+quint32 FloorsSlice::texture(int index) const {
+    return m_textures.at(index);
 }
 
 // -------------------------------------------------------
 
-void Floor::initializeGL(QOpenGLShaderProgram *programStatic){
-    if (m_programStatic == nullptr){
-        initializeOpenGLFunctions();
-
-        // Programs
-        m_programStatic = programStatic;
+void FloorsSlice::set(int index, quint32 texture) {
+    if (!m_occupied.testBit(index)) {
+        m_occupied.setBit(index);
+        m_count++;
     }
+    m_textures[index] = texture;
 }
 
 // -------------------------------------------------------
 
-void Floor::updateGL(){
-    Map::updateGLStatic(m_vertexBuffer, m_indexBuffer, m_vertices, m_indexes,
-                        m_vao, m_programStatic);
-}
+bool FloorsSlice::remove(int index) {
+    if (!m_occupied.testBit(index))
+        return false;
 
-// -------------------------------------------------------
+    m_occupied.clearBit(index);
+    m_count--;
 
-void Floor::paintGL(){
-    m_vao.bind();
-    glDrawElements(GL_TRIANGLES, m_indexes.size(), GL_UNSIGNED_INT, 0);
-    m_vao.bind();
+    return true;
 }
 
 // -------------------------------------------------------
@@ -213,21 +277,22 @@ void Floor::paintGL(){
 //
 // -------------------------------------------------------
 
-Floors::Floors() :
-    m_programStatic(nullptr)
+Floors::Floors(Portion& globalPortion) :
+    m_originX(globalPortion.x() * Wanok::portionSize),
+    m_originZ(globalPortion.z() * Wanok::portionSize)
 {
-    for (int i = 0; i < Position::LAYERS_NUMBER; i++)
-        m_floorsGL[i] = new Floor;
+
 }
 
 Floors::~Floors()
 {
-    QHash<Position, LandDatas*>::iterator i;
-    for (i = m_lands.begin(); i != m_lands.end(); i++)
-        delete i.value();
+    for (int i = 0; i < m_slices.size(); i++)
+        delete m_slices.at(i);
+}
 
-    for (int i = 0; i < Position::LAYERS_NUMBER; i++)
-        delete m_floorsGL[i];
+qint64 Floors::memorySize() const {
+    return m_slices.size() * (FloorsSlice::size() * sizeof(quint32) +
+                              FloorsSlice::size() / 8);
 }
 
 // -------------------------------------------------------
@@ -237,46 +302,88 @@ Floors::~Floors()
 // -------------------------------------------------------
 
 bool Floors::isEmpty() const{
-    return m_lands.size() == 0;
+    return m_slices.isEmpty();
 }
 
 // -------------------------------------------------------
 
-LandDatas* Floors::getLand(Position& p){
-    LandDatas* datas = m_lands.value(p);
-    // TODO : autotiles
+FloorsSlice* Floors::slice(int y, int yPlus) const {
+    for (int i = 0; i < m_slices.size(); i++) {
+        FloorsSlice* slice = m_slices.at(i);
+        if (slice->y() == y && slice->yPlus() == yPlus)
+            return slice;
+    }
 
-    return datas;
+    return nullptr;
 }
 
 // -------------------------------------------------------
 
-void Floors::setLand(Position& p, LandDatas *land){
-    m_lands.insert(p, land);
+bool Floors::localIndex(Position& p, int& index) const {
+    int x = p.x() - m_originX;
+    int z = p.z() - m_originZ;
+    if (x < 0 || x >= Wanok::portionSize || z < 0 ||
+        z >= Wanok::portionSize || p.layer() < 0 ||
+        p.layer() >= Position::LAYERS_NUMBER)
+    {
+        return false;
+    }
+    index = FloorsSlice::index(x, z, p.layer());
+
+    return true;
 }
 
 // -------------------------------------------------------
 
-LandDatas *Floors::removeLand(Position& p){
-    LandDatas* land = m_lands.value(p);
+void Floors::positionAt(const FloorsSlice* slice, int index,
+                        Position& p) const
+{
+    int x, z, layer;
+    FloorsSlice::coords(index, x, z, layer);
+    p = Position(m_originX + x, slice->y(), slice->yPlus(), m_originZ + z,
+                 layer);
+}
 
-    if (land != nullptr)
-        m_lands.remove(p);
+// -------------------------------------------------------
 
-    return land;
+MapEditorSubSelectionKind Floors::getLand(Position& p, QRect& texture) const
+{
+    int index;
+    FloorsSlice* floorsSlice = slice(p.y(), p.yPlus());
+    if (floorsSlice == nullptr || !localIndex(p, index) ||
+        !floorsSlice->isOccupied(index))
+    {
+        return MapEditorSubSelectionKind::None;
+    }
+    texture = m_palette.rect(floorsSlice->texture(index));
+    // TODO : autotiles
+
+    return MapEditorSubSelectionKind::Floors;
 }
 
 // -------------------------------------------------------
 
-bool Floors::addLand(Position& p, LandDatas *land){
-    if (land->getSubKind() == MapEditorSubSelectionKind::Floors){
-        LandDatas* previousLand = removeLand(p);
-
-        if (previousLand != nullptr)
-            delete previousLand;
+void Floors::setFloor(Position& p, const QRect& texture) {
+    int index;
+    if (!localIndex(p, index))
+        return;
 
-        setLand(p, land);
+    FloorsSlice* floorsSlice = slice(p.y(), p.yPlus());
+    if (floorsSlice == nullptr) {
+        floorsSlice = new FloorsSlice(p.y(), p.yPlus());
+        m_slices.append(floorsSlice);
     }
+    floorsSlice->set(index, m_palette.rectIndex(texture));
+}
+
+// -------------------------------------------------------
+
+bool Floors::addLand(Position& p, LandDatas *land){
+    if (land->getSubKind() == MapEditorSubSelectionKind::Floors)
+        setFloor(p, *((FloorDatas*) land)->textureRect());
+
+    // Only the texture is kept in the arrays
+    delete land;
 
     return true;
 }
@@ -284,10 +391,14 @@ bool Floors::addLand(Position& p, LandDatas *land){
 // -------------------------------------------------------
 
 bool Floors::deleteLand(Position& p){
-    LandDatas* previousLand = removeLand(p);
-
-    if (previousLand != nullptr)
-        delete previousLand;
+    int index;
+    FloorsSlice* floorsSlice = slice(p.y(), p.yPlus());
+    if (floorsSlice != nullptr && localIndex(p, index) &&
+        floorsSlice->remove(index) && floorsSlice->count() == 0)
+    {
+        m_slices.removeOne(floorsSlice);
+        delete floorsSlice;
+    }
 
     return true;
 }
@@ -295,21 +406,36 @@ bool Floors::deleteLand(Position& p){
 // -------------------------------------------------------
 
 void Floors::removeLandOut(MapProperties& properties) {
-    QList<Position> list;
-    QHash<Position, LandDatas*>::iterator i;
-    for (i = m_lands.begin(); i != m_lands.end(); i++) {
-        Position position = i.key();
-
-        if (position.x() >= properties.length() ||
-            position.z() >= properties.width())
-        {
-            delete *i;
-            list.push_back(position);
+    int minX = qMax(properties.length() - m_originX, 0);
+    int minZ = qMax(properties.width() - m_originZ, 0);
+
+    for (int i = m_slices.size() - 1; i >= 0; i--) {
+        FloorsSlice* floorsSlice = m_slices.at(i);
+        for (int layer = 0; layer < Position::LAYERS_NUMBER; layer++) {
+            for (int z = 0; z < Wanok::portionSize; z++) {
+                for (int x = (z >= minZ ? 0 : minX); x < Wanok::portionSize;
+                     x++)
+                {
+                    floorsSlice->remove(FloorsSlice::index(x, z, layer));
+                }
+            }
+        }
+        if (floorsSlice->count() == 0) {
+            m_slices.removeAt(i);
+            delete floorsSlice;
         }
     }
+}
 
-    for (int j = 0; j < list.size(); j++)
-        m_lands.remove(list.at(j));
+// -------------------------------------------------------
+
+bool Floors::isPreviewFloor(QHash<Position, MapElement*>& previewSquares,
+                            Position& p)
+{
+    MapElement* element = previewSquares.value(p);
+
+    return element != nullptr &&
+            element->getSubKind() == MapEditorSubSelectionKind::Floors;
 }
 
 // -------------------------------------------------------
@@ -318,69 +444,59 @@ void Floors::removeLandOut(MapProperties& properties) {
 //
 // -------------------------------------------------------
 
-void Floors::initializeVertices(QHash<Position, MapElement *> &previewSquares,
+void Floors::initializeVertices(MapPortionChunks& chunks,
+                                QHash<Position, MapElement *> &previewSquares,
                                 int squareSize, int width, int height){
-
-    // Clear all the floors
-    for (int j = 0; j < Position::LAYERS_NUMBER; j++)
-        m_floorsGL[j]->clearGL();
-
-    // Create temp hash for preview
-    QHash<Position, LandDatas*> landsWithPreview(m_lands);
+    int layers = Position::LAYERS_NUMBER;
+    QVector<MapPortionGeometry> floors(MapPortionChunks::count() * layers);
+
+    // Initialize vertices of the dirty chunks, the preview replaces the
+    // floors under it
+    Position p;
+    int chunk;
+    bool hasPreview = !previewSquares.isEmpty();
+    for (int i = 0; i < m_slices.size(); i++) {
+        const FloorsSlice* floorsSlice = m_slices.at(i);
+        for (int j = 0; j < FloorsSlice::size(); j++) {
+            if (!floorsSlice->isOccupied(j))
+                continue;
+
+            positionAt(floorsSlice, j, p);
+            chunk = chunks.index(p.x(), p.z());
+            if (!chunks.isDirty(chunk) ||
+                (hasPreview && isPreviewFloor(previewSquares, p)))
+            {
+                continue;
+            }
+            Floor::initializeVertices(floors[chunk * layers + p.layer()],
+                                      squareSize, width, height, p,
+                                      m_palette.rect(floorsSlice->texture(j)));
+        }
+    }
     QHash<Position, MapElement*>::iterator it;
     for (it = previewSquares.begin(); it != previewSquares.end(); it++) {
         MapElement* element = it.value();
-        if (element->getSubKind() == MapEditorSubSelectionKind::Floors)
-            landsWithPreview[it.key()] = (LandDatas*) element;
-    }
-
-    // Initialize vertices
-    QHash<Position, LandDatas*>::iterator i;
-    for (i = landsWithPreview.begin(); i != landsWithPreview.end(); i++) {
-        LandDatas* land = i.value();
-        Position p = i.key();
-
-        switch (land->getSubKind()){
-        case MapEditorSubSelectionKind::Floors:
-            m_floorsGL[p.layer()]->initializeVertices(squareSize, width, height,
-                                                      p, (FloorDatas*) land);
-            break;
-        default:
-            break;
+        if (element->getSubKind() == MapEditorSubSelectionKind::Floors) {
+            p = it.key();
+            chunk = chunks.index(p.x(), p.z());
+            if (!chunks.isDirty(chunk))
+                continue;
+            Floor::initializeVertices(floors[chunk * layers + p.layer()],
+                                      squareSize, width, height, p,
+                                      *((FloorDatas*) element)->textureRect());
         }
     }
-}
-
-// -------------------------------------------------------
-
-void Floors::initializeGL(QOpenGLShaderProgram *programStatic){
-    if (m_programStatic == nullptr){
-        initializeOpenGLFunctions();
 
-        m_programStatic = programStatic;
+    // The layers are drawn in order, in a single range
+    for (int i = 0; i < MapPortionChunks::count(); i++) {
+        if (!chunks.isDirty(i))
+            continue;
+        for (int j = 0; j < layers; j++) {
+            chunks.add(i, MapPortionRangeKind::Floors, j,
+                       MapPortionRangeKind::Floors, -1,
+                       floors[i * layers + j]);
+        }
     }
-
-    // Floors
-    for (int i = 0; i < Position::LAYERS_NUMBER; i++)
-        m_floorsGL[i]->initializeGL(programStatic);
-}
-
-// -------------------------------------------------------
-
-void Floors::updateGL(){
-
-    // Floors
-    for (int i = 0; i < Position::LAYERS_NUMBER; i++)
-        m_floorsGL[i]->updateGL();
-}
-
-// -------------------------------------------------------
-
-void Floors::paintGL(){
-
-    // Floors
-    for (int i = 0; i < Position::LAYERS_NUMBER; i++)
-        m_floorsGL[i]->paintGL();
 }
 
 // -------------------------------------------------------
@@ -391,16 +507,15 @@ void Floors::paintGL(){
 
 void Floors::read(const QJsonObject & json){
     QJsonArray tabFloors = json["floors"].toArray();
+    QRect texture;
 
     // Floors
     for (int i = 0; i < tabFloors.size(); i++){
         QJsonObject obj = tabFloors.at(i).toObject();
         Position p;
         p.read(obj["k"].toArray());
-        QJsonObject objLand = obj["v"].toObject();
-        FloorDatas* floor = new FloorDatas;
-        floor->read(objLand);
-        m_lands[p] = floor;
+        FloorDatas::readTexture(obj["v"].toObject(), texture);
+        setFloor(p, texture);
     }
 }
 
@@ -408,29 +523,65 @@ void Floors::read(const QJsonObject & json){
 
 void Floors::write(QJsonObject & json) const{
     QJsonArray tabFloors;
-
-    QHash<Position, LandDatas*>::const_iterator i;
-    for (i = m_lands.begin(); i != m_lands.end(); i++){
-        QJsonObject objHash;
-        QJsonArray tabKey;
-        i.key().write(tabKey);
-        LandDatas* land = i.value();
-        QJsonObject objLand;
-        land->write(objLand);
-        objHash["k"] = tabKey;
-        objHash["v"] = objLand;
-
-        switch (land->getSubKind()){
-        case MapEditorSubSelectionKind::Floors:
+    Position p;
+
+    for (int i = 0; i < m_slices.size(); i++) {
+        const FloorsSlice* floorsSlice = m_slices.at(i);
+        for (int j = 0; j < FloorsSlice::size(); j++) {
+            if (!floorsSlice->isOccupied(j))
+                continue;
+
+            QJsonObject objHash;
+            QJsonArray tabKey;
+            QJsonObject objLand;
+            positionAt(floorsSlice, j, p);
+            p.write(tabKey);
+            FloorDatas::writeTexture(objLand,
+                                     m_palette.rect(floorsSlice->texture(j)));
+            objHash["k"] = tabKey;
+            objHash["v"] = objLand;
             tabFloors.append(objHash);
-            break;
-        case MapEditorSubSelectionKind::Autotiles:
-            break;
-        case MapEditorSubSelectionKind::Water:
-            break;
-        default:
-            break;
         }
     }
     json["floors"] = tabFloors;
 }
+
+// -------------------------------------------------------
+
+void Floors::readBinary(QDataStream& stream, const BinaryPalette& palette){
+    quint32 count, textureIndex;
+
+    // Floors
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+        Position p;
+        p.readBinary(stream);
+        stream >> textureIndex;
+        setFloor(p, palette.rect(textureIndex));
+    }
+}
+
+// -------------------------------------------------------
+
+void Floors::writeBinary(QDataStream& stream, BinaryPalette& palette) const{
+    quint32 count = 0;
+    Position p;
+
+    for (int i = 0; i < m_slices.size(); i++)
+        count += m_slices.at(i)->count();
+
+    // Floors
+    stream << count;
+    for (int i = 0; i < m_slices.size(); i++) {
+        const FloorsSlice* floorsSlice = m_slices.at(i);
+        for (int j = 0; j < FloorsSlice::size(); j++) {
+            if (!floorsSlice->isOccupied(j))
+                continue;
+
+            positionAt(floorsSlice, j, p);
+            p.writeBinary(stream);
+            stream << palette.rectIndex(
+                          m_palette.rect(floorsSlice->texture(j)));
+        }
+    }
+}
@@ -23,15 +23,13 @@
 #include <QHash>
 #include <QRect>
 #include <QVector>
-#include <QOpenGLFunctions>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLBuffer>
-#include <QOpenGLVertexArrayObject>
+#include <QBitArray>
 #include "lands.h"
 #include "position.h"
 #include "height.h"
 #include "vertex.h"
 #include "mapproperties.h"
+#include "mapportionchunks.h"
 
 // -------------------------------------------------------
 //
@@ -50,8 +48,12 @@ public:
     QRect* textureRect() const;
     virtual MapEditorSubSelectionKind getSubKind() const;
 
+    static void readTexture(const QJsonObject &json, QRect& texture);
+    static void writeTexture(QJsonObject &json, const QRect& texture);
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject & json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 protected:
     QRect* m_textureRect;
@@ -65,71 +67,95 @@ protected:
 //
 // -------------------------------------------------------
 
-class Floor : protected QOpenGLFunctions
+class Floor
 {
 public:
-    Floor();
-    virtual ~Floor();
     static QVector3D verticesQuad[];
     static GLuint indexesQuad[];
     static int nbVerticesQuad;
     static int nbIndexesQuad;
 
-    void clearGL();
-    void initializeVertices(int squareSize, int width, int height,
-                            Position3D& p, FloorDatas* floor);
-    void initializeGL(QOpenGLShaderProgram* programStatic);
-    void updateGL();
-    void paintGL();
+    static void initializeVertices(MapPortionGeometry& geometry,
+                                   int squareSize, int width, int height,
+                                   Position3D& p, const QRect& texture);
+};
+
+// -------------------------------------------------------
+//
+//  CLASS FloorsSlice
+//
+//  All the floors of a portion at the same height. The squares are
+//  stored in arrays indexed by (x, z, layer): an occupancy bitset and
+//  the index of the texture rect in the palette of the floors.
+//
+// -------------------------------------------------------
+
+class FloorsSlice
+{
+public:
+    FloorsSlice(int y, int yPlus);
+    int y() const;
+    int yPlus() const;
+    int count() const;
+    static int size();
+    static int index(int x, int z, int layer);
+    static void coords(int index, int& x, int& z, int& layer);
+    bool isOccupied(int index) const;
+    quint32 texture(int index) const;
+    void set(int index, quint32 texture);
+    bool remove(int index);
 
 protected:
+    int m_y;
+    int m_yPlus;
     int m_count;
-
-    // OpenGL informations
-    QOpenGLBuffer m_vertexBuffer;
-    QOpenGLBuffer m_indexBuffer;
-    QVector<Vertex> m_vertices;
-    QVector<GLuint> m_indexes;
-    QOpenGLVertexArrayObject m_vao;
-    QOpenGLShaderProgram* m_programStatic;
+    QBitArray m_occupied;
+    QVector<quint32> m_textures;
 };
 
 // -------------------------------------------------------
 //
 //  CLASS Floors
 //
-//  A set of static floors in a portion of the map.
+//  A set of static floors in a portion of the map, stored by height
+//  slices.
 //
 // -------------------------------------------------------
 
-class Floors : public Serializable, protected QOpenGLFunctions
+class Floors : public Serializable, public BinarySerializable
 {
 public:
-    Floors();
+    Floors(Portion& globalPortion);
     virtual ~Floors();
     bool isEmpty() const;
-    LandDatas* getLand(Position& p);
-    void setLand(Position& p, LandDatas* floor);
-    LandDatas* removeLand(Position& p);
+    qint64 memorySize() const;
+    MapEditorSubSelectionKind getLand(Position& p, QRect& texture) const;
     bool addLand(Position& p, LandDatas* land);
     bool deleteLand(Position& p);
+    void setFloor(Position& p, const QRect& texture);
 
     void removeLandOut(MapProperties& properties);
 
-    void initializeVertices(QHash<Position, MapElement*>& previewSquares,
+    void initializeVertices(MapPortionChunks& chunks,
+                            QHash<Position, MapElement*>& previewSquares,
                             int squareSize, int width, int height);
-    void initializeGL(QOpenGLShaderProgram* programStatic);
-    void updateGL();
-    void paintGL();
 
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject &json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 protected:
-    QHash<Position, LandDatas*> m_lands;
-    Floor* m_floorsGL[2];
-
-    QOpenGLShaderProgram* m_programStatic;
+    int m_originX;
+    int m_originZ;
+    QList<FloorsSlice*> m_slices;
+    BinaryPalette m_palette;
+
+    FloorsSlice* slice(int y, int yPlus) const;
+    bool localIndex(Position& p, int& index) const;
+    void positionAt(const FloorsSlice* slice, int index, Position& p) const;
+    static bool isPreviewFloor(QHash<Position, MapElement*>& previewSquares,
+                               Position& p);
 };
 
 #endif // FLOORS_H
@@ -191,3 +191,24 @@ void GridPosition::write(QJsonArray &json) const{
     json.append(m_y);
     json.append(m_yPlus);
 }
+
+// -------------------------------------------------------
+
+void GridPosition::readBinary(QDataStream& stream){
+    qint32 x1, z1, x2, z2, y, yPlus;
+
+    stream >> x1 >> z1 >> x2 >> z2 >> y >> yPlus;
+    m_x1 = x1;
+    m_z1 = z1;
+    m_x2 = x2;
+    m_z2 = z2;
+    m_y = y;
+    m_yPlus = yPlus;
+}
+
+// -------------------------------------------------------
+
+void GridPosition::writeBinary(QDataStream& stream) const{
+    stream << (qint32) m_x1 << (qint32) m_z1 << (qint32) m_x2
+           << (qint32) m_z2 << (qint32) m_y << (qint32) m_yPlus;
+}
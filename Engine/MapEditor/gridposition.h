@@ -57,6 +57,8 @@ public:
 
     void read(const QJsonArray &json);
     void write(QJsonArray & json) const;
+    void readBinary(QDataStream& stream);
+    void writeBinary(QDataStream& stream) const;
 
 protected:
     int m_x1;
@@ -22,12 +22,15 @@
 #include <QJsonDocument>
 #include <cmath>
 #include <QDir>
+#include <QElapsedTimer>
 #include "map.h"
 #include "wanok.h"
 #include "widgettreelocalmaps.h"
 #include "systemmapobject.h"
 #include "systemspecialelement.h"
 
+const qint64 Map::UPLOAD_BUDGET = 4;
+
 // -------------------------------------------------------
 //
 //  CONSTRUCTOR / DESTRUCTOR / GET / SET
@@ -37,23 +40,35 @@
 Map::Map() :
     m_mapProperties(new MapProperties),
     m_mapPortions(nullptr),
+    m_pack(nullptr),
+    m_portionLoader(nullptr),
+    m_portionsOpening(0),
+    m_portionsCulled(0),
+    m_updatePortionTime(0),
     m_cursor(nullptr),
     m_modelObjects(new QStandardItemModel),
     m_saved(true),
     m_programStatic(nullptr),
     m_programFaceSprite(nullptr),
+    m_texturesCache(nullptr),
     m_textureTileset(nullptr),
     m_textureObjectSquare(nullptr)
 {
 
 }
 
-Map::Map(int id) :
+Map::Map(int id, MapTextureCache* texturesCache) :
     m_mapPortions(nullptr),
+    m_pack(nullptr),
+    m_portionLoader(nullptr),
+    m_portionsOpening(0),
+    m_portionsCulled(0),
+    m_updatePortionTime(0),
     m_cursor(nullptr),
     m_modelObjects(new QStandardItemModel),
     m_programStatic(nullptr),
     m_programFaceSprite(nullptr),
+    m_texturesCache(texturesCache),
     m_textureTileset(nullptr),
     m_textureObjectSquare(nullptr)
 {
@@ -62,9 +77,13 @@ Map::Map(int id) :
                                           ->pathCurrentProject(),
                                           Wanok::pathMaps);
     m_pathMap = Wanok::pathCombine(pathMaps, realName);
+    m_pack = new MapPack(m_pathMap);
     QString pathTemp = Wanok::pathCombine(m_pathMap,
                                           Wanok::TEMP_MAP_FOLDER_NAME);
 
+    // Finish a save that was interrupted
+    MapJournal::recover(m_pathMap);
+
     // Reading map infos
     if (!Wanok::mapsToSave.contains(id)){
         Wanok::deleteAllFiles(pathTemp);
@@ -78,26 +97,56 @@ Map::Map(int id) :
     m_portionsRay = Wanok::get()->getPortionsRay() + 1;
     m_squareSize = Wanok::get()->getSquareSize();
 
+    // Maps saved before the list of the pictures used read all their
+    // portions once, so that the list is complete before being written
+    QSet<int> characters, walls;
+    if (!m_mapProperties->getTexturesUsed(characters, walls))
+        readTexturesUsed();
+
     // Loading textures
     loadTextures();
+
+    // The singletons are not thread safe: create them before the loaders
+    MapPortionWriter::get();
+    m_portionLoader = new MapPortionLoader(this);
 }
 
 Map::Map(MapProperties* properties) :
     m_mapProperties(properties),
     m_mapPortions(nullptr),
+    m_pack(nullptr),
+    m_portionLoader(nullptr),
+    m_portionsOpening(0),
+    m_portionsCulled(0),
+    m_updatePortionTime(0),
     m_cursor(nullptr),
     m_modelObjects(new QStandardItemModel),
     m_programStatic(nullptr),
-    m_programFaceSprite(nullptr)
+    m_programFaceSprite(nullptr),
+    m_texturesCache(nullptr),
+    m_textureTileset(nullptr),
+    m_textureObjectSquare(nullptr)
 {
 
 }
 
 Map::~Map() {
+
+    // Workers are reading the files and the textures of the map
+    if (m_portionLoader != nullptr) {
+        delete m_portionLoader;
+        m_portionLoader = nullptr;
+    }
+
+    // Temp portions of this map could be read as soon as it is reopened
+    MapPortionWriter::get()->flush();
+
     delete m_cursor;
     delete m_mapProperties;
     deletePortions();
     SuperListItem::deleteModel(m_modelObjects);
+    if (m_pack != nullptr)
+        delete m_pack;
 
     if (m_programStatic != nullptr)
         delete m_programStatic;
@@ -136,7 +185,8 @@ MapPortion* Map::mapPortion(int x, int y, int z) const {
 MapPortion* Map::mapPortionFromGlobal(Portion& p) const {
     Portion portion = getLocalFromGlobalPortion(p);
 
-    return mapPortion(portion);
+    // Outside of the window, the ring buffer slot belongs to another portion
+    return isInPortion(portion, 0) ? mapPortion(portion) : nullptr;
 }
 
 MapPortion* Map::mapPortionBrut(int index) const {
@@ -146,9 +196,10 @@ MapPortion* Map::mapPortionBrut(int index) const {
 int Map::portionIndex(int x, int y, int z) const {
     int size = getMapPortionSize();
 
-    return ((x + m_portionsRay) * size * size) +
-           ((y + m_portionsRay) * size) +
-           (z + m_portionsRay);
+    // The window is a ring buffer: a global portion always uses the same slot
+    return (Wanok::mod(m_portionsOrigin.x() + x, size) * size * size) +
+           (Wanok::mod(m_portionsOrigin.y() + y, size) * size) +
+           Wanok::mod(m_portionsOrigin.z() + z, size);
 }
 
 int Map::getMapPortionSize() const {
@@ -171,6 +222,66 @@ void Map::setMapPortion(Portion &p, MapPortion* mapPortion) {
     setMapPortion(p.x(), p.y(), p.z(), mapPortion);
 }
 
+Portion Map::portionsOrigin() const { return m_portionsOrigin; }
+
+bool Map::isOpening() const { return m_portionsOpening > 0; }
+
+bool Map::isStreaming() const {
+    return m_portionLoader != nullptr && !m_portionLoader->isIdle();
+}
+
+int Map::openingProgress() const {
+    if (m_portionsOpening == 0)
+        return 100;
+
+    int loaded = m_portionsOpening - m_portionsLoading.size();
+
+    return qMax(0, loaded * 100 / m_portionsOpening);
+}
+
+int Map::prefetchRay() const {
+    return m_portionsRay +
+            qMax(0, Wanok::get()->engineSettings()->prefetchDepth());
+}
+
+int Map::portionsDrawn() const { return m_portionsVisible.size(); }
+
+int Map::portionsCulled() const { return m_portionsCulled; }
+
+qint64 Map::updatePortionTime() const { return m_updatePortionTime; }
+
+void Map::setPortionsOrigin(Portion& p) {
+    int ray = prefetchRay();
+    m_portionsOrigin = p;
+    if (m_portionLoader != nullptr)
+        m_portionLoader->cancelOutside(m_portionsOrigin, ray);
+
+    // Portions leaving the window are only kept if they could come back soon
+    QSet<Portion>::iterator i = m_portionsLoading.begin();
+    while (i != m_portionsLoading.end()) {
+        if (isNearOrigin(*i, m_portionsRay))
+            i++;
+        else {
+            if (isNearOrigin(*i, ray))
+                m_portionsPrefetching.insert(*i);
+            i = m_portionsLoading.erase(i);
+        }
+    }
+    i = m_portionsPrefetching.begin();
+    while (i != m_portionsPrefetching.end()) {
+        if (isNearOrigin(*i, ray))
+            i++;
+        else
+            i = m_portionsPrefetching.erase(i);
+    }
+}
+
+MapPortionCache* Map::portionsCache() { return &m_portionsCache; }
+
+qint64 Map::cacheBudget() const {
+    return (qint64) Wanok::get()->engineSettings()->cacheMemory() << 20;
+}
+
 MapObjects* Map::objectsPortion(Portion &p){
     return objectsPortion(p.x(), p.y(), p.z());
 }
@@ -231,8 +342,9 @@ void Map::writeDefaultMap(QString path){
                                                    new QStandardItemModel,
                                                    new QStandardItemModel);
     mapPortion.addObject(position, o);
-    Wanok::writeJSON(Wanok::pathCombine(pathMap, getPortionPathMap(0, 0, 0)),
-                     mapPortion);
+    MapPack pack(pathMap);
+    writePortion(pack, pathMap, 0, 0, 0, mapPortion);
+    pack.commit();
 }
 
 // -------------------------------------------------------
@@ -249,22 +361,7 @@ QString Map::writeMap(QString path, MapProperties& properties,
     Wanok::writeJSON(Wanok::pathCombine(dirMap, Wanok::fileMapInfos),
                      properties);
 
-    // Portions
-    int lx = (properties.length() - 1) / Wanok::portionSize;
-    int ly = (properties.depth() + properties.height() - 1) /
-            Wanok::portionSize;;
-    int lz = (properties.width() - 1) / Wanok::portionSize;
-    for (int i = 0; i <= lx; i++){
-        for (int j = 0; j <= ly; j++){
-            for (int k = 0; k <= lz; k++){
-                QJsonObject obj;
-                Wanok::writeOtherJSON(
-                            Wanok::pathCombine(dirMap,
-                                               getPortionPathMap(i, j, k)),
-                            obj);
-            }
-        }
-    }
+    // Portions are empty when there is no file, so nothing to write here
 
     // Objects
     QJsonObject json;
@@ -290,25 +387,7 @@ void Map::correctMap(QString path, MapProperties& previousProperties,
                                  newPortionMaxY,
                                  newPortionMaxZ);
 
-    // Write empty portions
-    for (int i = portionMaxX + 1; i <= newPortionMaxX; i++) {
-        for (int j = 0; j <= newPortionMaxY; j++) {
-            for (int k = 0; k <= newPortionMaxZ; k++)
-                Map::writeEmptyMap(path, i, j, k);
-        }
-    }
-    for (int j = portionMaxY + 1; j <= newPortionMaxY;j++) {
-        for (int i = 0; i <= newPortionMaxX; i++) {
-            for (int k = 0; k <= newPortionMaxZ; k++)
-                Map::writeEmptyMap(path, i, j, k);
-        }
-    }
-    for (int k = portionMaxZ + 1; k <= newPortionMaxZ; k++) {
-        for (int i = 0; i <= newPortionMaxX; i++) {
-            for (int j = 0; j <= newPortionMaxY; j++)
-                Map::writeEmptyMap(path, i, j, k);
-        }
-    }
+    // New portions don't need any file: a missing portion is an empty one
 
     int difLength = previousProperties.length() - properties.length();
     int difWidth = previousProperties.width() - properties.width();
@@ -317,13 +396,21 @@ void Map::correctMap(QString path, MapProperties& previousProperties,
     if (difLength > 0 || difWidth > 0 || difHeight > 0) {
         QStandardItemModel* model = new QStandardItemModel;
         QList<int> listDeletedObjectsIDs;
+        MapPack pack(path);
+        MapJournal journal(path);
+
+        // The new versions of the portions are prepared in temp, which only
+        // contains copies of the saved files at this point
+        MapJournal::recover(path);
+        Wanok::deleteAllFiles(Wanok::pathCombine(path,
+                                                 Wanok::TEMP_MAP_FOLDER_NAME));
         Map::loadObjects(model, path, false);
 
         // Complete delete
         for (int i = newPortionMaxX + 1; i <= portionMaxX; i++) {
             for (int j = 0; j <= portionMaxY; j++) {
                 for (int k = 0; k <= portionMaxZ; k++)
-                    deleteCompleteMap(path, i, j, k);
+                    deleteCompleteMap(journal, i, j, k);
             }
         }
         deleteObjects(model, newPortionMaxX + 1, portionMaxX, 0, portionMaxY, 0,
@@ -331,7 +418,7 @@ void Map::correctMap(QString path, MapProperties& previousProperties,
         for (int k = newPortionMaxZ + 1; k <= portionMaxZ; k++) {
             for (int i = 0; i <= portionMaxX; i++) {
                 for (int j = 0; j <= portionMaxY; j++)
-                    deleteCompleteMap(path, i, j, k);
+                    deleteCompleteMap(journal, i, j, k);
             }
         }
         deleteObjects(model, 0, portionMaxX, 0, portionMaxY, newPortionMaxZ + 1,
@@ -340,39 +427,35 @@ void Map::correctMap(QString path, MapProperties& previousProperties,
         // Remove only cut items
         for (int i = 0; i <= newPortionMaxX; i++) {
             for (int j = 0; j <= newPortionMaxY; j++) {
-                deleteMapElements(listDeletedObjectsIDs, path, i, j,
-                                  newPortionMaxZ, properties);
+                deleteMapElements(listDeletedObjectsIDs, pack, journal, path,
+                                  i, j, newPortionMaxZ, properties);
             }
         }
         for (int k = 0; k <= newPortionMaxZ; k++) {
             for (int j = 0; j <= newPortionMaxY; j++) {
-                deleteMapElements(listDeletedObjectsIDs, path, newPortionMaxX,
-                                  j, k, properties);
+                deleteMapElements(listDeletedObjectsIDs, pack, journal, path,
+                                  newPortionMaxX, j, k, properties);
             }
         }
         deleteObjectsByID(model, listDeletedObjectsIDs);
-
-        // Save
-        Map::saveObjects(model, path, false);
-
+        Map::saveObjects(model, path, true);
+        journal.renameFile(Wanok::fileMapObjects);
         SuperListItem::deleteModel(model);
-    }           
-}
-
-// -------------------------------------------------------
 
-void Map::writeEmptyMap(QString path, int i, int j, int k) {
-    QString pathPortion = Wanok::pathCombine(path, getPortionPathMap(i, j, k));
-    QJsonObject obj;
-    Wanok::writeOtherJSON(pathPortion, obj);
+        // Save: nothing is changed in the map before the journal is complete
+        pack.close();
+        if (journal.commit())
+            journal.apply();
+    }
 }
 
 // -------------------------------------------------------
 
-void Map::deleteCompleteMap(QString path, int i, int j, int k) {
-    QString pathPortion = Wanok::pathCombine(path, getPortionPathMap(i, j, k));
-    QFile file(pathPortion);
-    file.remove();
+void Map::deleteCompleteMap(MapJournal& journal, int i, int j, int k) {
+    Portion portion(i, j, k);
+    journal.removePortion(portion);
+    journal.removeFile(getPortionPathMap(i, j, k));
+    journal.removeFile(getPortionPathMapBinary(i, j, k));
 }
 
 // -------------------------------------------------------
@@ -415,20 +498,44 @@ void Map::deleteObjectsByID(QStandardItemModel* model,
 
 // -------------------------------------------------------
 
-void Map::deleteMapElements(QList<int>& listDeletedObjectsIDs, QString path,
-                            int i, int j, int k, MapProperties &properties)
+void Map::deleteMapElements(QList<int>& listDeletedObjectsIDs, MapPack& pack,
+                            MapJournal& journal, QString path, int i, int j,
+                            int k, MapProperties &properties)
 {
     Portion portion(i, j, k);
-    QString pathPortion = Wanok::pathCombine(path, getPortionPathMap(i, j, k));
     MapPortion mapPortion(portion);
-    Wanok::readJSON(pathPortion, mapPortion);
+    QString pathTemp = Wanok::pathCombine(path, Wanok::TEMP_MAP_FOLDER_NAME);
+    QString fileNameJSON = getPortionPathMap(i, j, k);
+    QString fileNameBinary = getPortionPathMapBinary(i, j, k);
+
+    // A corner portion is visited twice: the first version is in temp
+    QString pathBinary = Wanok::pathCombine(pathTemp, fileNameBinary);
+    bool prepared = QFile(pathBinary).exists();
+    if (prepared)
+        Wanok::readBinary(pathBinary, mapPortion);
+    else
+        readPortion(pack, path, i, j, k, mapPortion);
 
     // Removing cut content
     mapPortion.removeLandOut(properties);
     mapPortion.removeSpritesOut(properties);
     mapPortion.removeObjectsOut(listDeletedObjectsIDs, properties);
 
-    Wanok::writeJSON(pathPortion, mapPortion);
+    // The binary file in temp is moved to the pack by the journal
+    if (mapPortion.isEmpty()) {
+        QFile(pathBinary).remove();
+        QFile(Wanok::pathCombine(pathTemp, fileNameJSON)).remove();
+        journal.removePortion(portion);
+        journal.removeFile(fileNameJSON);
+    }
+    else {
+        Wanok::writeBinary(pathBinary, mapPortion);
+        Wanok::writeJSON(Wanok::pathCombine(pathTemp, fileNameJSON),
+                         mapPortion);
+        journal.setPortion(portion);
+        journal.renameFile(fileNameJSON);
+    }
+    journal.removeFile(fileNameBinary);
 }
 
 // -------------------------------------------------------
@@ -440,12 +547,111 @@ QString Map::getPortionPathMap(int i, int j, int k){
 
 // -------------------------------------------------------
 
-QString Map::getPortionPath(int i, int j, int k) {
-    QString tempPath = getPortionPathTemp(i, j, k);
-    if (QFile(tempPath).exists())
-        return tempPath;
+QString Map::getPortionPathMapBinary(int i, int j, int k){
+    return QString::number(i) + "_" + QString::number(j) + "_" +
+            QString::number(k) + "." + Wanok::EXTENSION_PORTION_BINARY;
+}
+
+// -------------------------------------------------------
+
+void Map::readPortion(MapPack& pack, QString path, int i, int j, int k,
+                      MapPortion& mapPortion)
+{
+    Portion portion(i, j, k);
+
+    // Pack first, then the separated files of the previous layouts. A
+    // decode can fail halfway: the next source must not be merged with it
+    if (pack.readPortion(portion, mapPortion))
+        return;
+    mapPortion.clear();
+    if (Wanok::readBinary(Wanok::pathCombine(path,
+                                             getPortionPathMapBinary(i, j, k)),
+                          mapPortion))
+    {
+        return;
+    }
+    mapPortion.clear();
+    Wanok::readJSON(Wanok::pathCombine(path, getPortionPathMap(i, j, k)),
+                    mapPortion);
+}
+
+// -------------------------------------------------------
+
+void Map::writePortion(MapPack& pack, QString path, int i, int j, int k,
+                       MapPortion& mapPortion)
+{
+    Portion portion(i, j, k);
+    if (mapPortion.isEmpty())
+        pack.removePortion(portion);
+    else {
+        QByteArray data;
+        Wanok::writeBinaryData(data, mapPortion);
+        pack.setPortion(portion, data);
+    }
+    QFile(Wanok::pathCombine(path, getPortionPathMapBinary(i, j, k))).remove();
+    exportPortion(Wanok::pathCombine(path, getPortionPathMap(i, j, k)),
+                  mapPortion);
+}
+
+// -------------------------------------------------------
+
+void Map::exportPortion(QString path, MapPortion& mapPortion) {
+    if (mapPortion.isEmpty())
+        QFile(path).remove();
     else
-        return Wanok::pathCombine(m_pathMap, getPortionPathMap(i, j, k));
+        Wanok::writeJSON(path, mapPortion);
+}
+
+// -------------------------------------------------------
+
+void Map::saveTemp(QString path) {
+    MapPortionWriter::get()->flush();
+    MapJournal::recover(path);
+    QString pathTemp = Wanok::pathCombine(path, Wanok::TEMP_MAP_FOLDER_NAME);
+    QFileInfoList files = QDir(pathTemp).entryInfoList(QDir::Files);
+    MapJournal journal(path);
+
+    for (int i = 0; i < files.size(); i++){
+        const QFileInfo& file = files.at(i);
+
+        // Binary portions go to the pack, and the game reads the json ones
+        QStringList coords = file.completeBaseName().split("_");
+        if (file.suffix() == Wanok::EXTENSION_PORTION_BINARY &&
+            coords.size() == 3)
+        {
+            Portion portion(coords.at(0).toInt(), coords.at(1).toInt(),
+                            coords.at(2).toInt());
+            MapPortion mapPortion(portion);
+            QFile loadFile(file.filePath());
+            if (!loadFile.open(QIODevice::ReadOnly))
+                continue;
+            QByteArray data = loadFile.readAll();
+            loadFile.close();
+
+            // An empty temp file is a portion that was cleared
+            QString fileNameJSON = file.completeBaseName() + ".json";
+            Wanok::readBinaryData(data, mapPortion);
+            if (mapPortion.isEmpty()) {
+                journal.removePortion(portion);
+                journal.removeFile(fileNameJSON);
+            }
+            else {
+                journal.setPortion(portion);
+                Wanok::writeJSON(Wanok::pathCombine(pathTemp, fileNameJSON),
+                                 mapPortion);
+                journal.renameFile(fileNameJSON);
+            }
+            journal.removeFile(file.fileName());
+        }
+
+        // Json portions are the ones prepared by an interrupted save
+        else if (file.suffix() != "json" || coords.size() != 3)
+            journal.renameFile(file.fileName());
+    }
+
+    // Nothing is changed in the map before the journal is complete
+    if (!journal.isEmpty() && journal.commit())
+        journal.apply();
 }
 
 // -------------------------------------------------------
@@ -453,7 +659,7 @@ QString Map::getPortionPath(int i, int j, int k) {
 QString Map::getPortionPathTemp(int i, int j, int k) {
     return Wanok::pathCombine(m_pathMap, Wanok::pathCombine(
                                   Wanok::TEMP_MAP_FOLDER_NAME,
-                                  getPortionPathMap(i, j, k)));
+                                  getPortionPathMapBinary(i, j, k)));
 }
 
 // -------------------------------------------------------
@@ -478,18 +684,34 @@ void Map::setModelObjects(QStandardItemModel* model){
 // -------------------------------------------------------
 
 void Map::loadTextures(){
+
+    // The loader threads read the textures and the atlas
+    if (m_portionLoader != nullptr) {
+        m_portionLoader->drain();
+        m_portionsOutdated.clear();
+    }
     deleteTextures();
 
+    // Only the pictures used by the map are decoded right now, in the
+    // thread pool. The other ones are decoded when first needed
+    QSet<int> charactersUsed, wallsUsed;
+    bool all = !m_mapProperties->getTexturesUsed(charactersUsed, wallsUsed);
+
     // Tileset
-    m_textureTileset = new QOpenGLTexture(
-                QImage(m_mapProperties->tileset()->picture()
-                       ->getPath(PictureKind::Tilesets)));
-    m_textureTileset->setMinificationFilter(QOpenGLTexture::Filter::Nearest);
-    m_textureTileset->setMagnificationFilter(QOpenGLTexture::Filter::Nearest);
+    SystemPicture* picture = m_mapProperties->tileset()->picture();
+    m_textureTileset = createTexture(PictureKind::Tilesets, picture->id(),
+                                     picture->getPath(PictureKind::Tilesets));
+    m_textureTileset->decode();
 
     // Characters && walls
-    loadCharacters(PictureKind::Characters, m_texturesCharacters);
-    loadSpecialPictures(PictureKind::Walls, m_texturesSpriteWalls);
+    loadCharacters(PictureKind::Characters, m_texturesCharacters,
+                   charactersUsed, all);
+    loadSpecialPictures(PictureKind::Walls, m_texturesSpriteWalls, wallsUsed,
+                        all);
+
+    // The pictures used are packed in the atlas, so the loader threads
+    // can map the texture coordinates of objects and walls
+    m_textureAtlas.build(m_texturesCache);
 
     // Object square
     m_textureObjectSquare = new QOpenGLTexture(
@@ -498,45 +720,80 @@ void Map::loadTextures(){
                 QOpenGLTexture::Filter::Nearest);
     m_textureObjectSquare->setMagnificationFilter(
                 QOpenGLTexture::Filter::Nearest);
+
+    // The portions dropped by the drain are loaded with the new textures
+    if (m_portionLoader != nullptr) {
+        m_portionsPrefetching.clear();
+        QSet<Portion>::iterator i;
+        for (i = m_portionsLoading.begin(); i != m_portionsLoading.end(); i++) {
+            Portion portion = *i;
+            m_portionLoader->load(portion);
+        }
+    }
 }
 
 // -------------------------------------------------------
 
 void Map::deleteTextures(){
     if (m_textureTileset != nullptr)
-        delete m_textureTileset;
-    for (QHash<int, QOpenGLTexture*>::iterator i = m_texturesCharacters.begin();
+        deleteTexture(m_textureTileset);
+    for (QHash<int, MapTexture*>::iterator i = m_texturesCharacters.begin();
          i != m_texturesCharacters.end(); i++)
     {
-        delete *i;
+        deleteTexture(*i);
     }
-    for (QHash<int, QOpenGLTexture*>::iterator i = m_texturesSpriteWalls.begin()
-         ; i != m_texturesSpriteWalls.end(); i++)
+    m_texturesCharacters.clear();
+    for (QHash<int, MapTexture*>::iterator i = m_texturesSpriteWalls.begin();
+         i != m_texturesSpriteWalls.end(); i++)
     {
-        delete *i;
+        deleteTexture(*i);
     }
+    m_texturesSpriteWalls.clear();
+    m_textureAtlas.clear();
     if (m_textureObjectSquare != nullptr)
         delete m_textureObjectSquare;
+    m_textureTileset = nullptr;
+    m_textureObjectSquare = nullptr;
+}
+
+// -------------------------------------------------------
+
+MapTexture* Map::createTexture(PictureKind kind, int id, QString path) {
+    if (m_texturesCache != nullptr)
+        return m_texturesCache->acquire(kind, id, path);
+
+    return new MapTexture(path);
+}
+
+// -------------------------------------------------------
+
+void Map::deleteTexture(MapTexture* texture) {
+    if (m_texturesCache != nullptr)
+        m_texturesCache->release(texture);
+    else
+        delete texture;
 }
 
 // -------------------------------------------------------
 
-void Map::loadCharacters(PictureKind kind,
-                         QHash<int, QOpenGLTexture*>& textures)
+void Map::loadCharacters(PictureKind kind, QHash<int, MapTexture*>& textures,
+                         QSet<int>& used, bool all)
 {
     SystemPicture* picture;
     QStandardItemModel* model = Wanok::get()->project()->picturesDatas()
             ->model(kind);
     for (int i = 0; i < model->invisibleRootItem()->rowCount(); i++){
         picture = (SystemPicture*) model->item(i)->data().value<qintptr>();
-        loadPicture(picture, kind, textures, picture->id());
+        loadPicture(picture, kind, textures, picture->id(),
+                    all || used.contains(picture->id()));
     }
 }
 
 // -------------------------------------------------------
 
 void Map::loadSpecialPictures(PictureKind kind,
-                              QHash<int, QOpenGLTexture*>& textures)
+                              QHash<int, MapTexture*>& textures,
+                              QSet<int>& used, bool all)
 {
     SystemSpecialElement* special;
     QStandardItemModel* model = Wanok::get()->project()->specialElementsDatas()
@@ -544,55 +801,73 @@ void Map::loadSpecialPictures(PictureKind kind,
     for (int i = 0; i < model->invisibleRootItem()->rowCount(); i++) {
         special = (SystemSpecialElement*) model->item(i)->data()
                 .value<qintptr>();
-        loadPicture(special->picture(), kind, textures, special->id());
+        loadPicture(special->picture(), kind, textures, special->id(),
+                    all || used.contains(special->id()));
     }
 }
 
 // -------------------------------------------------------
 
 void Map::loadPicture(SystemPicture* picture, PictureKind kind,
-                      QHash<int, QOpenGLTexture*>& textures, int id)
+                      QHash<int, MapTexture*>& textures, int id, bool preload)
 {
-    QOpenGLTexture* texture;
-    QImage image(1, 1, QImage::Format_ARGB32);
-    QString path = picture->getPath(kind);
-
-    if (path.isEmpty())
-        image.fill(QColor(0, 0, 0, 0));
-    else
-        image.load(path);
-
-    texture = new QOpenGLTexture(image);
-    texture->setMinificationFilter(QOpenGLTexture::Filter::Nearest);
-    texture->setMagnificationFilter(QOpenGLTexture::Filter::Nearest);
+    MapTexture* texture = createTexture(kind, picture->id(),
+                                        picture->getPath(kind));
+    if (preload) {
+        texture->decode();
+        m_textureAtlas.add(kind, id, texture);
+    }
     textures[id] = texture;
 }
 
 // -------------------------------------------------------
 
-MapPortion* Map::loadPortionMap(int i, int j, int k){
-
+bool Map::isPortionInMap(int i, int j, int k) const {
     int lx = (m_mapProperties->length() - 1) / Wanok::portionSize;
     int ly = (m_mapProperties->depth() + m_mapProperties->height() - 1) /
             Wanok::portionSize;;
     int lz = (m_mapProperties->width() - 1) / Wanok::portionSize;
 
-    if (i >= 0 && i <= lx && j >= 0 && j <= ly && k >= 0 && k <= lz){
-        Portion portion(i, j, k);
-        QString path = getPortionPath(i, j, k);
-        MapPortion* mapPortion = new MapPortion(portion);
-        Wanok::readJSON(path, *mapPortion);
-        mapPortion->setIsLoaded(false);
-        /*
-        ThreadMapPortionLoader thread(this, portion);
-        thread.start();
-        */
-        loadPortionThread(mapPortion);
-        mapPortion->setIsLoaded(true);
-        return mapPortion;
+    return i >= 0 && i <= lx && j >= 0 && j <= ly && k >= 0 && k <= lz;
+}
+
+// -------------------------------------------------------
+
+MapPortion* Map::loadPortionMap(int i, int j, int k){
+    if (!isPortionInMap(i, j, k))
+        return nullptr;
+
+    // Called by the loader threads too: save() can't move files meanwhile
+    QReadLocker locker(&m_lockFiles);
+    Portion portion(i, j, k);
+    QString path = getPortionPathTemp(i, j, k);
+    MapPortion* mapPortion = new MapPortion(portion);
+
+    // An empty temp file means the portion was cleared since last save
+    QByteArray data;
+    bool removed;
+    if (MapPortionWriter::get()->pending(path, data, removed)) {
+        if (removed)
+            readPortionPack(i, j, k, *mapPortion);
+        else if (!data.isEmpty() && !Wanok::readBinaryData(data, *mapPortion))
+            mapPortion->clear();
     }
+    else if (QFile(path).exists()) {
+        if (!Wanok::readBinary(path, *mapPortion))
+            mapPortion->clear();
+    }
+    else
+        readPortionPack(i, j, k, *mapPortion);
 
-    return nullptr;
+    return mapPortion;
+}
+
+// -------------------------------------------------------
+
+void Map::readPortionPack(int i, int j, int k, MapPortion& mapPortion) {
+    QMutexLocker locker(&m_mutexPack);
+
+    readPortion(*m_pack, m_pathMap, i, j, k, mapPortion);
 }
 
 
@@ -601,13 +876,77 @@ MapPortion* Map::loadPortionMap(int i, int j, int k){
 void Map::savePortionMap(MapPortion* mapPortion){
     Portion portion;
     mapPortion->getGlobalPortion(portion);
+
+    // A cached or prefetched copy of this portion would be outdated, and
+    // so would a load started before this save
+    m_portionsCache.remove(portion);
+    m_portionsPrefetching.remove(portion);
+    if (m_portionsLoading.contains(portion))
+        m_portionsOutdated.insert(portion);
+
+    // Keep the list of the pictures to preload when opening the map
+    QSet<int> characters, walls;
+    mapPortion->getTexturesUsed(characters, walls);
+    if (m_mapProperties->setTexturesUsed(portion, characters, walls))
+        saveMapProperties();
+
     QString path = getPortionPathTemp(portion.x(), portion.y(), portion.z());
+    MapPortionWriter* writer = MapPortionWriter::get();
     if (mapPortion->isEmpty()) {
-        QJsonObject obj;
-        Wanok::writeOtherJSON(path, obj);
+
+        // An empty file is only needed to hide a previously saved version
+        if (isPortionSaved(portion))
+            writer->write(path, QByteArray());
+        else
+            writer->remove(path);
+    }
+    else {
+
+        // Only the serialization is done here, the file is written later
+        QByteArray data;
+        Wanok::writeBinaryData(data, *mapPortion);
+        writer->write(path, data);
     }
-    else
-        Wanok::writeJSON(path, *mapPortion);
+}
+
+// -------------------------------------------------------
+
+bool Map::isPortionSaved(Portion& portion) {
+    int i = portion.x(), j = portion.y(), k = portion.z();
+
+    m_mutexPack.lock();
+    bool packed = m_pack->contains(portion);
+    m_mutexPack.unlock();
+
+    return packed ||
+            QFile(Wanok::pathCombine(m_pathMap,
+                                     getPortionPathMapBinary(i, j, k)))
+            .exists() ||
+            QFile(Wanok::pathCombine(m_pathMap, getPortionPathMap(i, j, k)))
+            .exists();
+}
+
+// -------------------------------------------------------
+
+void Map::readTexturesUsed() {
+    int lx, ly, lz;
+    m_mapProperties->getPortionsNumber(lx, ly, lz);
+    for (int i = 0; i <= lx; i++) {
+        for (int j = 0; j <= ly; j++) {
+            for (int k = 0; k <= lz; k++) {
+                MapPortion* mapPortion = loadPortionMap(i, j, k);
+                if (mapPortion == nullptr)
+                    continue;
+                Portion portion(i, j, k);
+                QSet<int> characters, walls;
+                mapPortion->getTexturesUsed(characters, walls);
+                m_mapProperties->setTexturesUsed(portion, characters, walls);
+                delete mapPortion;
+            }
+        }
+    }
+    m_mapProperties->setIsTexturesUsedKnown(true);
+    saveMapProperties();
 }
 
 // -------------------------------------------------------
@@ -632,14 +971,54 @@ QString Map::getMapObjectsPath() const{
 
 // -------------------------------------------------------
 
-void Map::loadPortion(int realX, int realY, int realZ, int x, int y, int z,
-                      bool visible)
+void Map::loadPortion(int realX, int realY, int realZ, int x, int y, int z)
 {
-    MapPortion* newMapPortion = loadPortionMap(realX, realY, realZ);
-    if (newMapPortion != nullptr)
-        newMapPortion->setIsVisible(visible);
+    // The slot stays empty until the loaded portion is uploaded
+    setMapPortion(x, y, z, nullptr);
+    if (!isPortionInMap(realX, realY, realZ))
+        return;
+
+    // A cached portion is already uploaded
+    Portion portion(realX, realY, realZ);
+    MapPortion* mapPortion = m_portionsCache.take(portion);
+    if (mapPortion != nullptr) {
+        setMapPortion(x, y, z, mapPortion);
+        return;
+    }
+    m_portionsLoading.insert(portion);
+    if (!m_portionsPrefetching.remove(portion))
+        m_portionLoader->load(portion);
+}
+
+// -------------------------------------------------------
+
+void Map::evictPortion(int x, int y, int z) {
+    MapPortion* mapPortion = this->mapPortion(x, y, z);
+    setMapPortion(x, y, z, nullptr);
+    if (mapPortion == nullptr)
+        return;
 
-    setMapPortion(x, y, z, newMapPortion);
+    // Kept decoded and uploaded, in case the cursor comes back
+    Portion portion;
+    mapPortion->getGlobalPortion(portion);
+    m_portionsCache.insert(portion, mapPortion, cacheBudget());
+}
+
+// -------------------------------------------------------
+
+void Map::prefetchPortion(Portion& portion) {
+    if (m_portionLoader == nullptr ||
+        m_portionsCache.memory() >= cacheBudget() ||
+        !isPortionInMap(portion.x(), portion.y(), portion.z()) ||
+        m_portionsCache.contains(portion) ||
+        m_portionsPrefetching.contains(portion) ||
+        m_portionsLoading.contains(portion))
+    {
+        return;
+    }
+
+    m_portionsPrefetching.insert(portion);
+    m_portionLoader->load(portion);
 }
 
 // -------------------------------------------------------
@@ -649,34 +1028,80 @@ void Map::loadPortionThread(MapPortion* portion)
     portion->initializeVertices(m_squareSize,
                                 m_textureTileset,
                                 m_texturesCharacters,
-                                m_texturesSpriteWalls);
-    portion->initializeGL(m_programStatic, m_programFaceSprite);
-    portion->updateGL();
+                                m_texturesSpriteWalls,
+                                m_textureAtlas);
 }
 
 // -------------------------------------------------------
 
-void Map::replacePortion(Portion& previousPortion, Portion& newPortion,
-                         bool visible)
-{
-    MapPortion* mapPortion = this->mapPortion(newPortion);
-    if (mapPortion != nullptr)
-        mapPortion->setIsVisible(visible);
+void Map::updateLoadedPortions() {
+    if (m_portionLoader == nullptr)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    MapPortion* mapPortion;
+    while (timer.elapsed() < UPLOAD_BUDGET &&
+           (mapPortion = m_portionLoader->takeLoaded()) != nullptr)
+    {
+        Portion portion;
+        mapPortion->getGlobalPortion(portion);
+        Portion local(portion.x() - m_portionsOrigin.x(),
+                      portion.y() - m_portionsOrigin.y(),
+                      portion.z() - m_portionsOrigin.z());
+
+        // Saved while it was loading: it is read again
+        if (m_portionsOutdated.remove(portion)) {
+            if (m_portionsLoading.contains(portion))
+                m_portionLoader->load(portion);
+            delete mapPortion;
+        }
+
+        // The window moved away, or the portion was loaded twice
+        else if (isInPortion(local, 0) && this->mapPortion(local) == nullptr)
+        {
+            initializePortionGL(mapPortion);
+            setMapPortion(local, mapPortion);
+            m_portionsLoading.remove(portion);
+        }
+        else if (!isInPortion(local, 0) &&
+                 m_portionsPrefetching.remove(portion))
+        {
+            initializePortionGL(mapPortion);
+            m_portionsCache.insert(portion, mapPortion, cacheBudget());
+        }
+        else
+            delete mapPortion;
+    }
+    if (m_portionsLoading.isEmpty())
+        m_portionsOpening = 0;
+}
+
+// -------------------------------------------------------
 
-    setMapPortion(previousPortion, mapPortion);
+void Map::initializePortionGL(MapPortion* mapPortion) {
+    mapPortion->initializeGL(m_programStatic, m_programFaceSprite);
+    mapPortion->updateGL();
+    mapPortion->setIsLoaded(true);
 }
 
 // -------------------------------------------------------
 
 void Map::updatePortion(MapPortion* mapPortion)
 {
-    mapPortion->setIsVisible(true);
+    QElapsedTimer timer;
+    timer.start();
+
     mapPortion->initializeVertices(m_squareSize,
                                    m_textureTileset,
                                    m_texturesCharacters,
-                                   m_texturesSpriteWalls);
+                                   m_texturesSpriteWalls,
+                                   m_textureAtlas);
     mapPortion->initializeGL(m_programStatic, m_programFaceSprite);
     mapPortion->updateGL();
+
+    // Latency of an edit, shown in the map editor statistics
+    m_updatePortionTime = timer.nsecsElapsed();
 }
 
 // -------------------------------------------------------
@@ -685,55 +1110,49 @@ void Map::loadPortions(Portion portion){
     deletePortions();
 
     m_mapPortions = new MapPortion*[getMapPortionTotalSize()];
+    m_portionsOrigin = portion;
 
-    // Load visible portions
-    for (int i = -m_portionsRay + 1; i <= m_portionsRay - 1; i++) {
-        for (int j = -m_portionsRay + 1; j <= m_portionsRay - 1; j++) {
-            for (int k = -m_portionsRay + 1; k <= m_portionsRay - 1; k++) {
-                loadPortion(i + portion.x(), j + portion.y(), k + portion.z(),
-                            i, j, k, true);
-            }
+    // The cursor portion first, and then ring by ring around it
+    QList<Portion> portions;
+    for (int i = -m_portionsRay; i <= m_portionsRay; i++) {
+        for (int j = -m_portionsRay; j <= m_portionsRay; j++) {
+            for (int k = -m_portionsRay; k <= m_portionsRay; k++)
+                portions.append(Portion(i, j, k));
         }
     }
+    qSort(portions.begin(), portions.end(), Map::isPortionCloser);
+    for (int i = 0; i < portions.size(); i++) {
+        const Portion& local = portions.at(i);
+        loadPortion(local.x() + portion.x(), local.y() + portion.y(),
+                    local.z() + portion.z(), local.x(), local.y(), local.z());
+    }
+    m_portionsOpening = m_portionsLoading.size();
+}
 
-    // Load not visible portions
-    QList<int> list;
-    list << -m_portionsRay << m_portionsRay;
-
-    for (int l = 0; l < list.size(); l++) {
-        int i = list.at(l);
-
-        // Vertical bar
-        for (int j = -m_portionsRay; j <= m_portionsRay; j++) {
-            for (int k = -m_portionsRay; k <= m_portionsRay; k++) {
-                loadPortion(i + portion.x(), j + portion.y(), k + portion.z(),
-                            i, j, k, false);
-            }
-        }
+// -------------------------------------------------------
 
-        // Horizontal bar
-        int k = i;
-        for (i = -m_portionsRay + 1; i <= m_portionsRay - 1; i++) {
-            for (int j = -m_portionsRay; j <= m_portionsRay; j++) {
-                loadPortion(i + portion.x(), j + portion.y(), k + portion.z(),
-                            i, j, k, false);
-            }
-        }
+bool Map::isPortionCloser(const Portion& a, const Portion& b) {
+    int ringA = qMax(qAbs(a.x()), qMax(qAbs(a.y()), qAbs(a.z())));
+    int ringB = qMax(qAbs(b.x()), qMax(qAbs(b.y()), qAbs(b.z())));
+    if (ringA != ringB)
+        return ringA < ringB;
 
-        // Height
-        int j = k;
-        for (i = -m_portionsRay + 1; i <= m_portionsRay - 1; i++) {
-            for (int k = -m_portionsRay + 1; k <= m_portionsRay - 1; k++) {
-                loadPortion(i + portion.x(), j + portion.y(), k + portion.z(),
-                            i, j, k, false);
-            }
-        }
-    }
+    return a.x() * a.x() + a.y() * a.y() + a.z() * a.z() <
+            b.x() * b.x() + b.y() * b.y() + b.z() * b.z();
 }
 
 // -------------------------------------------------------
 
 void Map::deletePortions(){
+    if (m_portionLoader != nullptr)
+        m_portionLoader->cancelAll();
+    m_portionsLoading.clear();
+    m_portionsOutdated.clear();
+    m_portionsOpening = 0;
+    m_portionsCache.clear();
+    m_portionsPrefetching.clear();
+    m_portionsVisible.clear();
+    m_portionsCulled = 0;
     if (m_mapPortions != nullptr) {
         int totalSize = getMapPortionTotalSize();
         for (int i = 0; i < totalSize; i++)
@@ -773,6 +1192,73 @@ bool Map::isInPortion(Portion& portion, int offset) const{
 
 // -------------------------------------------------------
 
+bool Map::isNearOrigin(const Portion& portion, int ray) const {
+    return qAbs(portion.x() - m_portionsOrigin.x()) <= ray &&
+            qAbs(portion.y() - m_portionsOrigin.y()) <= ray &&
+            qAbs(portion.z() - m_portionsOrigin.z()) <= ray;
+}
+
+// -------------------------------------------------------
+
+bool Map::isPortionVisible(MapPortion* mapPortion) const {
+    if (mapPortion == nullptr || !mapPortion->isLoaded())
+        return false;
+
+    // Only the border of the window is hidden
+    Portion portion;
+    mapPortion->getGlobalPortion(portion);
+
+    return isNearOrigin(portion, m_portionsRay - 1);
+}
+
+// -------------------------------------------------------
+
+bool Map::isBoxInFrustum(const QBox3D& box, const QVector4D* planes) {
+    QVector3D minimum = box.minimum();
+    QVector3D maximum = box.maximum();
+
+    // Outside as soon as the corner the most in front of one plane is
+    // still behind it
+    for (int i = 0; i < 6; i++) {
+        const QVector4D& plane = planes[i];
+        QVector3D corner(plane.x() >= 0 ? maximum.x() : minimum.x(),
+                         plane.y() >= 0 ? maximum.y() : minimum.y(),
+                         plane.z() >= 0 ? maximum.z() : minimum.z());
+        if (QVector3D::dotProduct(plane.toVector3D(), corner) + plane.w() < 0)
+            return false;
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void Map::updateVisiblePortions(QMatrix4x4& modelviewProjection) {
+    m_portionsVisible.clear();
+    m_portionsCulled = 0;
+
+    // Frustum planes extracted from the rows of the matrix
+    QVector4D rowW = modelviewProjection.row(3);
+    QVector4D planes[6];
+    for (int i = 0; i < 3; i++) {
+        planes[i * 2] = rowW + modelviewProjection.row(i);
+        planes[i * 2 + 1] = rowW - modelviewProjection.row(i);
+    }
+
+    int totalSize = getMapPortionTotalSize();
+    for (int i = 0; i < totalSize; i++) {
+        MapPortion* mapPortion = this->mapPortionBrut(i);
+        if (!isPortionVisible(mapPortion) || mapPortion->buffer()->isEmpty())
+            continue;
+        if (isBoxInFrustum(mapPortion->buffer()->box(), planes))
+            m_portionsVisible.append(mapPortion);
+        else
+            m_portionsCulled++;
+    }
+}
+
+// -------------------------------------------------------
+
 bool Map::isInSomething(Position3D& position, Portion& portion,
                         int offset) const
 {
@@ -901,10 +1387,13 @@ bool Map::deleteObject(Position& p, MapPortion *mapPortion,
 // -------------------------------------------------------
 
 void Map::save(){
-    QString pathTemp = Wanok::pathCombine(m_pathMap,
-                                          Wanok::TEMP_MAP_FOLDER_NAME);
-    Wanok::copyAllFiles(pathTemp, m_pathMap);
-    Wanok::deleteAllFiles(pathTemp);
+
+    // Release the memory map before the pack is written
+    QWriteLocker locker(&m_lockFiles);
+    m_mutexPack.lock();
+    m_pack->close();
+    m_mutexPack.unlock();
+    saveTemp(m_pathMap);
 }
 
 // -------------------------------------------------------
@@ -974,6 +1463,11 @@ void Map::initializeGL(){
                                                  ":/Shaders/spriteFace.vert");
     m_programFaceSprite->addShaderFromSourceFile(QOpenGLShader::Fragment,
                                                  ":/Shaders/spriteFace.frag");
+
+    // The billboards attributes are set up by MapPortionBuffer
+    m_programFaceSprite->bindAttributeLocation("centerPosition", 0);
+    m_programFaceSprite->bindAttributeLocation("texRect", 1);
+    m_programFaceSprite->bindAttributeLocation("size", 2);
     m_programFaceSprite->link();
     m_programFaceSprite->bind();
 
@@ -991,116 +1485,75 @@ void Map::initializeGL(){
 
 // -------------------------------------------------------
 
-void Map::updateGLStatic(QOpenGLBuffer &vertexBuffer,
-                         QOpenGLBuffer &indexBuffer,
-                         QVector<Vertex> &vertices,
-                         QVector<GLuint> &indexes,
-                         QOpenGLVertexArrayObject &vao,
-                         QOpenGLShaderProgram* program)
+MapTexture* Map::getRangeTexture(const MapPortionRange& range) const {
+    switch (range.kind) {
+    case MapPortionRangeKind::Walls:
+        return m_texturesSpriteWalls.value(range.textureID);
+    case MapPortionRangeKind::Objects:
+        return m_texturesCharacters.value(range.textureID);
+    case MapPortionRangeKind::Atlas:
+        return m_textureAtlas.texture();
+    default:
+        return m_textureTileset;
+    }
+}
+
+// -------------------------------------------------------
+
+void Map::paintPortionRange(MapPortion* mapPortion, MapPortionRangeKind kind)
 {
-    program->bind();
-
-    // If existing VAO or VBO, destroy it
-    if (vao.isCreated())
-        vao.destroy();
-    if (vertexBuffer.isCreated())
-        vertexBuffer.destroy();
-    if (indexBuffer.isCreated())
-        indexBuffer.destroy();
-
-    // Create new VBO for vertex
-    vertexBuffer.create();
-    vertexBuffer.bind();
-    vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vertexBuffer.allocate(vertices.constData(),
-                          vertices.size() * sizeof(Vertex));
-
-    // Create new VBO for indexes
-    indexBuffer.create();
-    indexBuffer.bind();
-    indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    indexBuffer.allocate(indexes.constData(),
-                         indexes.size() * sizeof(GLuint));
-
-    // Create new VAO
-    vao.create();
-    vao.bind();
-    program->enableAttributeArray(0);
-    program->enableAttributeArray(1);
-    program->setAttributeBuffer(0, GL_FLOAT, Vertex::positionOffset(),
-                                Vertex::positionTupleSize,
-                                Vertex::stride());
-    program->setAttributeBuffer(1, GL_FLOAT, Vertex::texOffset(),
-                                Vertex::texCoupleSize,
-                                Vertex::stride());
-    indexBuffer.bind();
-
-    // Releases
-    vao.release();
-    indexBuffer.release();
-    vertexBuffer.release();
-    program->release();
-}
-
-// -------------------------------------------------------
-
-void Map::updateGLFace(QOpenGLBuffer &vertexBuffer,
-                       QOpenGLBuffer &indexBuffer,
-                       QVector<VertexBillboard> &vertices,
-                       QVector<GLuint> &indexes,
-                       QOpenGLVertexArrayObject &vao,
-                       QOpenGLShaderProgram* program)
+    MapPortionBuffer* buffer = mapPortion->buffer();
+    const QList<MapPortionRange>& ranges = buffer->rangesStatic();
+    bool isBound = false;
+
+    for (int i = 0; i < ranges.size(); i++) {
+        const MapPortionRange& range = ranges.at(i);
+        if (range.kind == kind) {
+            if (!isBound) {
+                if (!buffer->bindStatic())
+                    return;
+                isBound = true;
+            }
+            buffer->paintStatic(range);
+        }
+    }
+    if (isBound)
+        buffer->release();
+}
+
+// -------------------------------------------------------
+
+void Map::paintPortionRanges(MapPortion* mapPortion, bool face,
+                             MapTexture*& textureBound)
 {
-    program->bind();
-
-    // If existing VAO or VBO, destroy it
-    if (vao.isCreated())
-        vao.destroy();
-    if (vertexBuffer.isCreated())
-        vertexBuffer.destroy();
-    if (indexBuffer.isCreated())
-        indexBuffer.destroy();
-
-    // Create new VBO for vertex
-    vertexBuffer.create();
-    vertexBuffer.bind();
-    vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vertexBuffer.allocate(vertices.constData(),
-                          vertices.size() * sizeof(VertexBillboard));
-
-    // Create new VBO for indexes
-    indexBuffer.create();
-    indexBuffer.bind();
-    indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    indexBuffer.allocate(indexes.constData(),
-                         indexes.size() * sizeof(GLuint));
-
-    // Create new VAO
-    vao.create();
-    vao.bind();
-    program->enableAttributeArray(0);
-    program->enableAttributeArray(1);
-    program->enableAttributeArray(2);
-    program->enableAttributeArray(3);
-    program->setAttributeBuffer(0, GL_FLOAT, VertexBillboard::positionOffset(),
-                                VertexBillboard::positionTupleSize,
-                                VertexBillboard::stride());
-    program->setAttributeBuffer(1, GL_FLOAT, VertexBillboard::texOffset(),
-                                VertexBillboard::texCoupleSize,
-                                VertexBillboard::stride());
-    program->setAttributeBuffer(2, GL_FLOAT, VertexBillboard::sizeOffset(),
-                                VertexBillboard::sizeCoupleSize,
-                                VertexBillboard::stride());
-    program->setAttributeBuffer(3, GL_FLOAT, VertexBillboard::modelOffset(),
-                                VertexBillboard::modelCoupleSize,
-                                VertexBillboard::stride());
-    indexBuffer.bind();
-
-    // Releases
-    vao.release();
-    indexBuffer.release();
-    vertexBuffer.release();
-    program->release();
+    MapPortionBuffer* buffer = mapPortion->buffer();
+    if (!(face ? buffer->bindFace() : buffer->bindStatic()))
+        return;
+
+    const QList<MapPortionRange>& ranges = face ? buffer->rangesFace()
+                                                : buffer->rangesStatic();
+    for (int i = 0; i < ranges.size(); i++) {
+        const MapPortionRange& range = ranges.at(i);
+
+        // Floors and squares of objects have their own pass
+        if (range.kind == MapPortionRangeKind::Floors ||
+            range.kind == MapPortionRangeKind::ObjectsSquares)
+        {
+            continue;
+        }
+        MapTexture* texture = getRangeTexture(range);
+        if (texture == nullptr)
+            continue;
+        if (texture != textureBound) {
+            texture->bind();
+            textureBound = texture;
+        }
+        if (face)
+            buffer->paintFace(range);
+        else
+            buffer->paintStatic(range);
+    }
+    buffer->release();
 }
 
 // -------------------------------------------------------
@@ -1113,11 +1566,9 @@ void Map::paintFloors(QMatrix4x4& modelviewProjection)
                                      modelviewProjection);
     m_textureTileset->bind();
 
-    int totalSize = getMapPortionTotalSize();
-    for (int i = 0; i < totalSize; i++) {
-        MapPortion* mapPortion = this->mapPortionBrut(i);
-        if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-            mapPortion->paintFloors();
+    for (int i = 0; i < m_portionsVisible.size(); i++) {
+        paintPortionRange(m_portionsVisible.at(i),
+                          MapPortionRangeKind::Floors);
     }
 
     m_programStatic->release();
@@ -1129,51 +1580,18 @@ void Map::paintOthers(QMatrix4x4 &modelviewProjection,
                       QVector3D &cameraRightWorldSpace,
                       QVector3D &cameraUpWorldSpace)
 {
-    int totalSize = getMapPortionTotalSize();
-    MapPortion* mapPortion;
+    MapTexture* textureBound;
 
+    // Sprites, objects and walls: one VAO per portion, one draw per texture
     m_programStatic->bind();
     m_programStatic->setUniformValue(u_modelviewProjectionStatic,
                                      modelviewProjection);
     m_textureTileset->bind();
+    textureBound = m_textureTileset;
+    for (int i = 0; i < m_portionsVisible.size(); i++)
+        paintPortionRanges(m_portionsVisible.at(i), false, textureBound);
 
-    // Sprites
-    for (int i = 0; i < totalSize; i++) {
-        mapPortion = this->mapPortionBrut(i);
-        if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-            mapPortion->paintSprites();
-    }
-
-    // Objects
-    QHash<int, QOpenGLTexture*>::iterator it;
-    for (it = m_texturesCharacters.begin();
-         it != m_texturesCharacters.end(); it++)
-    {
-        int textureID = it.key();
-        QOpenGLTexture* texture = it.value();
-        for (int i = 0; i < totalSize; i++) {
-            mapPortion = this->mapPortionBrut(i);
-            if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-                mapPortion->paintObjectsStaticSprites(textureID, texture);
-        }
-    }
-
-    // Walls
-    QHash<int, QOpenGLTexture*>::iterator itWalls;
-    for (itWalls = m_texturesSpriteWalls.begin();
-         itWalls != m_texturesSpriteWalls.end(); itWalls++)
-    {
-        int textureID = itWalls.key();
-        QOpenGLTexture* texture = itWalls.value();
-        texture->bind();
-        for (int i = 0; i < totalSize; i++) {
-            mapPortion = this->mapPortionBrut(i);
-            if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-                mapPortion->paintSpritesWalls(textureID);
-        }
-    }
-
-    // Face sprites
+    // Face sprites and objects face sprites
     m_programStatic->release();
     m_programFaceSprite->bind();
     m_programFaceSprite->setUniformValue(u_cameraRightWorldspace,
@@ -1183,33 +1601,17 @@ void Map::paintOthers(QMatrix4x4 &modelviewProjection,
     m_programFaceSprite->setUniformValue(u_modelViewProjection,
                                          modelviewProjection);
     m_textureTileset->bind();
-    for (int i = 0; i < totalSize; i++) {
-        mapPortion = this->mapPortionBrut(i);
-        if (mapPortion != nullptr && mapPortion->isVisible())
-            mapPortion->paintFaceSprites();
-    }
-
-    // Objects face sprites
-    for (it = m_texturesCharacters.begin();
-         it != m_texturesCharacters.end(); it++)
-    {
-        int textureID = it.key();
-        QOpenGLTexture* texture = it.value();
-        for (int i = 0; i < totalSize; i++) {
-            mapPortion = this->mapPortionBrut(i);
-            if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-                mapPortion->paintObjectsFaceSprites(textureID, texture);
-        }
-    }
+    textureBound = m_textureTileset;
+    for (int i = 0; i < m_portionsVisible.size(); i++)
+        paintPortionRanges(m_portionsVisible.at(i), true, textureBound);
     m_programFaceSprite->release();
 
     // Objects squares
     m_programStatic->bind();
     m_textureObjectSquare->bind();
-    for (int i = 0; i < totalSize; i++) {
-        mapPortion = this->mapPortionBrut(i);
-        if (mapPortion != nullptr && mapPortion->isVisibleLoaded())
-            mapPortion->paintObjectsSquares();
+    for (int i = 0; i < m_portionsVisible.size(); i++) {
+        paintPortionRange(m_portionsVisible.at(i),
+                          MapPortionRangeKind::ObjectsSquares);
     }
 
     m_programStatic->release();
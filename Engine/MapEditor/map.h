@@ -21,12 +21,18 @@
 #define MAP_H
 
 #include <QOpenGLTexture>
+#include <QReadWriteLock>
 #include "mapportion.h"
 #include "mapobjects.h"
 #include "mapproperties.h"
 #include "systemcommonobject.h"
-#include "threadmapportionloader.h"
+#include "mapportionloader.h"
+#include "mapportioncache.h"
 #include "cursor.h"
+#include "mappack.h"
+#include "maptexturecache.h"
+#include "mapportionwriter.h"
+#include "mapjournal.h"
 
 // -------------------------------------------------------
 //
@@ -40,9 +46,10 @@ class Map : protected QOpenGLFunctions
 {
 public:
     Map();
-    Map(int id);
+    Map(int id, MapTextureCache* texturesCache = nullptr);
     Map(MapProperties* properties);
     virtual ~Map();
+    const static qint64 UPLOAD_BUDGET;
     MapProperties* mapProperties() const;
     void setMapProperties(MapProperties* p);
     Cursor* cursor() const;
@@ -60,6 +67,17 @@ public:
     int getMapPortionTotalSize() const;
     void setMapPortion(int x, int y, int z, MapPortion *mapPortion);
     void setMapPortion(Portion& p, MapPortion *mapPortion);
+    Portion portionsOrigin() const;
+    bool isOpening() const;
+    bool isStreaming() const;
+    int openingProgress() const;
+    int prefetchRay() const;
+    int portionsDrawn() const;
+    int portionsCulled() const;
+    qint64 updatePortionTime() const;
+    MapPortionCache* portionsCache();
+    qint64 cacheBudget() const;
+    void setPortionsOrigin(Portion& p);
     MapObjects* objectsPortion(Portion& p);
     MapObjects* objectsPortion(int x, int y, int z);
     bool addObject(Position& p, MapPortion *mapPortion,
@@ -75,60 +93,67 @@ public:
     static void writeNewMap(QString path, MapProperties& properties);
     static void correctMap(QString path, MapProperties &previousProperties,
                            MapProperties& properties);
-    static void writeEmptyMap(QString path, int i, int j, int k);
-    static void deleteCompleteMap(QString path, int i, int j, int k);
+    static void deleteCompleteMap(MapJournal& journal, int i, int j, int k);
     static void deleteObjects(QStandardItemModel* model, int minI, int maxI,
                               int minJ, int maxJ, int minK, int maxK);
     static void deleteObjectsByID(QStandardItemModel* model,
                                   QList<int> &listDeletedObjectsIDs);
     static void deleteMapElements(QList<int> &listDeletedObjectsIDs,
+                                  MapPack& pack, MapJournal& journal,
                                   QString path, int i, int j, int k,
                                   MapProperties& properties);
     static void writeDefaultMap(QString path);
     static QString writeMap(QString path, MapProperties& properties,
                             QJsonArray &jsonObject);
     static QString getPortionPathMap(int i, int j, int k);
+    static QString getPortionPathMapBinary(int i, int j, int k);
+    static void readPortion(MapPack& pack, QString path, int i, int j, int k,
+                            MapPortion& mapPortion);
+    static void writePortion(MapPack& pack, QString path, int i, int j, int k,
+                             MapPortion& mapPortion);
+    static void exportPortion(QString path, MapPortion& mapPortion);
+    static void saveTemp(QString path);
     static void setModelObjects(QStandardItemModel* model);
 
-    static void updateGLStatic(QOpenGLBuffer& vertexBuffer,
-                               QOpenGLBuffer& indexBuffer,
-                               QVector<Vertex>& vertices,
-                               QVector<GLuint>& indexes,
-                               QOpenGLVertexArrayObject& vao,
-                               QOpenGLShaderProgram* program);
-    static void updateGLFace(QOpenGLBuffer& vertexBuffer,
-                             QOpenGLBuffer& indexBuffer,
-                             QVector<VertexBillboard>& vertices,
-                             QVector<GLuint>& indexes,
-                             QOpenGLVertexArrayObject& vao,
-                             QOpenGLShaderProgram* program);
     void loadTextures();
     void deleteTextures();
-    void loadCharacters(PictureKind kind,
-                        QHash<int, QOpenGLTexture*>& textures);
+    MapTexture* createTexture(PictureKind kind, int id, QString path);
+    void deleteTexture(MapTexture* texture);
+    void loadCharacters(PictureKind kind, QHash<int, MapTexture*>& textures,
+                        QSet<int>& used, bool all);
     void loadSpecialPictures(PictureKind kind,
-                             QHash<int, QOpenGLTexture*>& textures);
+                             QHash<int, MapTexture*>& textures,
+                             QSet<int>& used, bool all);
     void loadPicture(SystemPicture* picture, PictureKind kind,
-                     QHash<int, QOpenGLTexture*>& textures, int id);
-    QString getPortionPath(int i, int j, int k);
+                     QHash<int, MapTexture*>& textures, int id, bool preload);
     QString getPortionPathTemp(int i, int j, int k);
+    bool isPortionInMap(int i, int j, int k) const;
     MapPortion* loadPortionMap(int i, int j, int k);
+    void readTexturesUsed();
+    void readPortionPack(int i, int j, int k, MapPortion& mapPortion);
     void savePortionMap(MapPortion* mapPortion);
+    bool isPortionSaved(Portion& portion);
     void saveMapProperties();
     QString getMapInfosPath() const;
     QString getMapObjectsPath() const;
-    void loadPortion(int realX, int realY, int realZ, int x, int y, int z,
-                     bool visible);
+    void loadPortion(int realX, int realY, int realZ, int x, int y, int z);
     void loadPortionThread(MapPortion *portion);
-    void replacePortion(Portion& previousPortion, Portion& newPortion,
-                        bool visible);
+    void evictPortion(int x, int y, int z);
+    void prefetchPortion(Portion& portion);
+    void updateLoadedPortions();
+    void initializePortionGL(MapPortion* mapPortion);
     void updatePortion(MapPortion *mapPortion);
     void updateSpriteWalls(MapEditorSubSelectionKind subSelection);
     void loadPortions(Portion portion);
+    static bool isPortionCloser(const Portion& a, const Portion& b);
     void deletePortions();
     bool isInGrid(Position3D& position) const;
     bool isPortionInGrid(Portion& portion) const;
     bool isInPortion(Portion& portion, int offset = -1) const;
+    bool isNearOrigin(const Portion& portion, int ray) const;
+    bool isPortionVisible(MapPortion* mapPortion) const;
+    static bool isBoxInFrustum(const QBox3D& box, const QVector4D* planes);
+    void updateVisiblePortions(QMatrix4x4& modelviewProjection);
     bool isInSomething(Position3D& position, Portion& portion,
                        int offset = -1) const;
     static Portion getGlobalPortion(Position3D &position);
@@ -154,15 +179,31 @@ public:
                                QJsonArray & tab);
 
     void initializeGL();
+    MapTexture* getRangeTexture(const MapPortionRange& range) const;
+    void paintPortionRange(MapPortion* mapPortion, MapPortionRangeKind kind);
+    void paintPortionRanges(MapPortion* mapPortion, bool face,
+                            MapTexture*& textureBound);
     void paintFloors(QMatrix4x4 &modelviewProjection);
     void paintOthers(QMatrix4x4 &modelviewProjection,
                      QVector3D& cameraRightWorldSpace,
                      QVector3D& cameraUpWorldSpace);
 
 private:
-    QList<ThreadMapPortionLoader> m_threadMapPortionLoaders;
     MapProperties* m_mapProperties;
     MapPortion** m_mapPortions;
+    Portion m_portionsOrigin;
+    MapPack* m_pack;
+    QMutex m_mutexPack;
+    QReadWriteLock m_lockFiles;
+    MapPortionLoader* m_portionLoader;
+    QSet<Portion> m_portionsLoading;
+    QSet<Portion> m_portionsOutdated;
+    int m_portionsOpening;
+    QVector<MapPortion*> m_portionsVisible;
+    int m_portionsCulled;
+    qint64 m_updatePortionTime;
+    QSet<Portion> m_portionsPrefetching;
+    MapPortionCache m_portionsCache;
     Cursor* m_cursor;
     QStandardItemModel* m_modelObjects;
     QString m_pathMap;
@@ -181,10 +222,12 @@ private:
     int u_modelViewProjection;
 
     // Textures
-    QOpenGLTexture* m_textureTileset;
-    QHash<int, QOpenGLTexture*> m_texturesCharacters;
-    QHash<int, QOpenGLTexture*> m_texturesSpriteWalls;
+    MapTextureCache* m_texturesCache;
+    MapTexture* m_textureTileset;
+    QHash<int, MapTexture*> m_texturesCharacters;
+    QHash<int, MapTexture*> m_texturesSpriteWalls;
     QOpenGLTexture* m_textureObjectSquare;
+    MapTextureAtlas m_textureAtlas;
 };
 
 #endif // MAP_H
@@ -58,3 +58,15 @@ void MapElement::read(const QJsonObject &){
 void MapElement::write(QJsonObject &) const{
 
 }
+
+// -------------------------------------------------------
+
+void MapElement::readBinary(QDataStream&, const BinaryPalette&){
+
+}
+
+// -------------------------------------------------------
+
+void MapElement::writeBinary(QDataStream&, BinaryPalette&) const{
+
+}
@@ -23,6 +23,7 @@
 #include "mapeditorsubselectionkind.h"
 #include "mapeditorselectionkind.h"
 #include "serializable.h"
+#include "binaryserializable.h"
 
 // -------------------------------------------------------
 //
@@ -32,7 +33,7 @@
 //
 // -------------------------------------------------------
 
-class MapElement : public Serializable
+class MapElement : public Serializable, public BinarySerializable
 {
 public:
     MapElement();
@@ -42,6 +43,8 @@ public:
 
     virtual void read(const QJsonObject &);
     virtual void write(QJsonObject &) const;
+    virtual void readBinary(QDataStream&, const BinaryPalette&);
+    virtual void writeBinary(QDataStream&, BinaryPalette&) const;
 };
 
 #endif // MAPELEMENT_H
@@ -0,0 +1,145 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPELEMENTPOOL_H
+#define MAPELEMENTPOOL_H
+
+#include <new>
+#include <utility>
+#include <QList>
+#include <QVector>
+
+// -------------------------------------------------------
+//
+//  CLASS MapElementPool
+//
+//  The storage of all the elements of one type in a portion. Elements
+//  are constructed inside blocks allocated for many of them, and the
+//  slots of destroyed elements are reused. Destroying the pool only
+//  releases the blocks: the destructors of the remaining elements are
+//  not called, so T must not own any memory.
+//
+//  Preview elements are never created here: the editor allocates them
+//  with new, the portion owns them until clearPreview() deletes them,
+//  and adding an element creates a new one in the pool instead of
+//  keeping the preview pointer.
+//
+// -------------------------------------------------------
+
+template <class T> class MapElementPool
+{
+public:
+    MapElementPool(int blockSize = 64);
+    ~MapElementPool();
+    const static int MAX_RESERVE = 4096;
+
+    int count() const;
+    void reserve(quint32 count);
+    template <class... Args> T* create(Args&&... args);
+    void destroy(T* element);
+
+protected:
+    int m_blockSize;
+    int m_count;
+    int m_used;
+    int m_capacity;
+    QList<char*> m_blocks;
+    QVector<T*> m_free;
+
+    void addBlock(int size);
+};
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+template <class T> MapElementPool<T>::MapElementPool(int blockSize) :
+    m_blockSize(blockSize),
+    m_count(0),
+    m_used(0),
+    m_capacity(0)
+{
+
+}
+
+template <class T> MapElementPool<T>::~MapElementPool()
+{
+    for (int i = 0; i < m_blocks.size(); i++)
+        ::operator delete(m_blocks.at(i));
+}
+
+template <class T> int MapElementPool<T>::count() const { return m_count; }
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+template <class T> void MapElementPool<T>::reserve(quint32 count) {
+    int size = (int) qMin(count, (quint32) MAX_RESERVE);
+    int available = m_free.size() + m_capacity - m_used;
+    if (size > available)
+        addBlock(qMax(size - available, m_blockSize));
+}
+
+// -------------------------------------------------------
+
+template <class T> template <class... Args>
+T* MapElementPool<T>::create(Args&&... args) {
+    void* slot;
+    if (!m_free.isEmpty()) {
+        slot = m_free.last();
+        m_free.removeLast();
+    }
+    else {
+        if (m_used == m_capacity)
+            addBlock(m_blockSize);
+        slot = m_blocks.last() + m_used * sizeof(T);
+        m_used++;
+    }
+    m_count++;
+
+    return new (slot) T(std::forward<Args>(args)...);
+}
+
+// -------------------------------------------------------
+
+template <class T> void MapElementPool<T>::destroy(T* element) {
+    element->~T();
+    m_free.append(element);
+    m_count--;
+}
+
+// -------------------------------------------------------
+
+template <class T> void MapElementPool<T>::addBlock(int size) {
+
+    // The remaining slots of the current block are kept for later
+    for (int i = m_used; i < m_capacity; i++)
+        m_free.append(reinterpret_cast<T*>(m_blocks.last() + i * sizeof(T)));
+
+    m_blocks.append(static_cast<char*>(::operator new(size * sizeof(T))));
+    m_used = 0;
+    m_capacity = size;
+}
+
+#endif // MAPELEMENTPOOL_H
@@ -0,0 +1,197 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include "mapjournal.h"
+#include "mappack.h"
+#include "map.h"
+#include "wanok.h"
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapJournal::MapJournal(QString pathMap) :
+    m_pathMap(pathMap)
+{
+
+}
+
+QString MapJournal::path() const {
+    return Wanok::pathCombine(m_pathMap, Wanok::FILE_MAP_JOURNAL);
+}
+
+bool MapJournal::isEmpty() const {
+    return m_portionsToSet.isEmpty() && m_portionsToRemove.isEmpty() &&
+            m_filesToRename.isEmpty() && m_filesToRemove.isEmpty();
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapJournal::setPortion(Portion& portion) {
+    m_portionsToSet.append(portion);
+}
+
+// -------------------------------------------------------
+
+void MapJournal::removePortion(Portion& portion) {
+    m_portionsToRemove.append(portion);
+}
+
+// -------------------------------------------------------
+
+void MapJournal::renameFile(QString fileName) {
+    m_filesToRename.append(fileName);
+}
+
+// -------------------------------------------------------
+
+void MapJournal::removeFile(QString fileName) {
+    m_filesToRemove.append(fileName);
+}
+
+// -------------------------------------------------------
+
+bool MapJournal::commit() const {
+    QJsonObject json;
+    write(json);
+
+    // The journal is either complete or not there at all
+    QSaveFile file(path());
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    return file.commit();
+}
+
+// -------------------------------------------------------
+
+bool MapJournal::apply() const {
+    QString pathTemp = Wanok::pathCombine(m_pathMap,
+                                          Wanok::TEMP_MAP_FOLDER_NAME);
+
+    // Pack: the binary files are still in temp until the journal is removed
+    MapPack pack(m_pathMap);
+    for (int i = 0; i < m_portionsToSet.size(); i++) {
+        Portion portion = m_portionsToSet.at(i);
+        QFile file(Wanok::pathCombine(pathTemp, Map::getPortionPathMapBinary(
+                                          portion.x(), portion.y(),
+                                          portion.z())));
+        if (file.open(QIODevice::ReadOnly)) {
+            pack.setPortion(portion, file.readAll());
+            file.close();
+        }
+    }
+    for (int i = 0; i < m_portionsToRemove.size(); i++) {
+        Portion portion = m_portionsToRemove.at(i);
+        pack.removePortion(portion);
+    }
+    if (!pack.commit())
+        return false;
+
+    // Files: a missing source means it was already renamed
+    for (int i = 0; i < m_filesToRemove.size(); i++)
+        QFile::remove(Wanok::pathCombine(m_pathMap, m_filesToRemove.at(i)));
+    for (int i = 0; i < m_filesToRename.size(); i++) {
+        QString source = Wanok::pathCombine(pathTemp, m_filesToRename.at(i));
+        QString target = Wanok::pathCombine(m_pathMap, m_filesToRename.at(i));
+        if (QFile(source).exists()) {
+            QFile::remove(target);
+            if (!QFile::rename(source, target))
+                return false;
+        }
+    }
+
+    QFile::remove(path());
+    Wanok::deleteAllFiles(pathTemp);
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapJournal::recover(QString pathMap) {
+    MapJournal journal(pathMap);
+    if (!QFile(journal.path()).exists())
+        return;
+
+    Wanok::readJSON(journal.path(), journal);
+    journal.apply();
+}
+
+// -------------------------------------------------------
+//
+//  READ / WRITE
+//
+// -------------------------------------------------------
+
+void MapJournal::readPortions(const QJsonArray &tab, QList<Portion>& list) {
+    for (int i = 0; i < tab.size(); i++) {
+        Portion portion;
+        portion.read(tab.at(i).toArray());
+        list.append(portion);
+    }
+}
+
+// -------------------------------------------------------
+
+void MapJournal::writePortions(QJsonArray &tab, const QList<Portion>& list) {
+    for (int i = 0; i < list.size(); i++) {
+        QJsonArray tabPortion;
+        list.at(i).write(tabPortion);
+        tab.append(tabPortion);
+    }
+}
+
+// -------------------------------------------------------
+
+void MapJournal::read(const QJsonObject &json) {
+    QJsonArray tab;
+
+    readPortions(json["set"].toArray(), m_portionsToSet);
+    readPortions(json["rm"].toArray(), m_portionsToRemove);
+    tab = json["files"].toArray();
+    for (int i = 0; i < tab.size(); i++)
+        m_filesToRename.append(tab.at(i).toString());
+    tab = json["rmFiles"].toArray();
+    for (int i = 0; i < tab.size(); i++)
+        m_filesToRemove.append(tab.at(i).toString());
+}
+
+// -------------------------------------------------------
+
+void MapJournal::write(QJsonObject &json) const {
+    QJsonArray tabSet, tabRemove;
+
+    writePortions(tabSet, m_portionsToSet);
+    writePortions(tabRemove, m_portionsToRemove);
+    json["set"] = tabSet;
+    json["rm"] = tabRemove;
+    json["files"] = QJsonArray::fromStringList(m_filesToRename);
+    json["rmFiles"] = QJsonArray::fromStringList(m_filesToRemove);
+}
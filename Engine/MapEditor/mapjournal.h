@@ -0,0 +1,67 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPJOURNAL_H
+#define MAPJOURNAL_H
+
+#include <QStringList>
+#include "serializable.h"
+#include "portion.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapJournal
+//
+//  The list of operations needed to move the temp folder of a map into
+//  the map. Every new file is first prepared inside temp, and the
+//  journal is then written atomically: this is the commit point. The
+//  operations only consist of renames and removes, so applying them
+//  again after an interruption always leads to the saved state.
+//
+// -------------------------------------------------------
+
+class MapJournal : public Serializable
+{
+public:
+    MapJournal(QString pathMap);
+    QString path() const;
+    bool isEmpty() const;
+    void setPortion(Portion& portion);
+    void removePortion(Portion& portion);
+    void renameFile(QString fileName);
+    void removeFile(QString fileName);
+    bool commit() const;
+    bool apply() const;
+    static void recover(QString pathMap);
+
+    virtual void read(const QJsonObject &json);
+    virtual void write(QJsonObject &json) const;
+
+protected:
+    QString m_pathMap;
+    QList<Portion> m_portionsToSet;
+    QList<Portion> m_portionsToRemove;
+    QStringList m_filesToRename;
+    QStringList m_filesToRemove;
+
+    static void readPortions(const QJsonArray &tab, QList<Portion>& list);
+    static void writePortions(QJsonArray &tab, const QList<Portion>& list);
+};
+
+#endif // MAPJOURNAL_H
@@ -17,6 +17,7 @@
     along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <QMap>
 #include "mapobjects.h"
 #include "wanok.h"
 #include "systemstate.h"
@@ -27,10 +28,7 @@
 //
 // -------------------------------------------------------
 
-MapObjects::MapObjects() :
-    m_vertexBuffer(QOpenGLBuffer::VertexBuffer),
-    m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-    m_programStatic(nullptr)
+MapObjects::MapObjects()
 {
 
 }
@@ -40,14 +38,25 @@ MapObjects::~MapObjects()
     QHash<Position, SystemCommonObject*>::const_iterator i;
     for (i = m_all.begin(); i != m_all.end(); i++)
         delete i.value();
-
-    clearSprites();
 }
 
 bool MapObjects::isEmpty() const{
     return m_all.empty();
 }
 
+qint64 MapObjects::memorySize() const {
+    return m_all.size() * sizeof(SystemCommonObject);
+}
+
+void MapObjects::getCharactersUsed(QSet<int>& characters) const {
+    QHash<Position, SystemCommonObject*>::const_iterator i;
+    for (i = m_all.begin(); i != m_all.end(); i++) {
+        SystemState* state = i.value()->getFirstState();
+        if (state != nullptr)
+            characters.insert(state->graphicsId());
+    }
+}
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
@@ -128,181 +137,102 @@ void MapObjects::removeObjectsOut(QList<int> &listDeletedObjectsIDs,
 //
 // -------------------------------------------------------
 
-void MapObjects::clearSprites(){
-    QHash<int, QList<SpriteObject*>*>::const_iterator i;
-    for (i = m_spritesStaticGL.begin(); i != m_spritesStaticGL.end(); i++){
-        QList<SpriteObject*>* list = i.value();
-        for (int j = 0; j < list->size(); j++)
-            delete list->at(j);
-        delete list;
-    }
-    QHash<int, QList<SpriteObject*>*>::const_iterator j;
-    for (j = m_spritesFaceGL.begin(); j != m_spritesFaceGL.end(); j++){
-        QList<SpriteObject*>* list = j.value();
-        for (int i = 0; i < list->size(); i++)
-            delete list->at(i);
-        delete list;
-    }
-
-    m_spritesStaticGL.clear();
-    m_spritesFaceGL.clear();
-}
-
-// -------------------------------------------------------
-
-void MapObjects::initializeVertices(int squareSize,
-                                    QHash<int, QOpenGLTexture *> &characters,
+void MapObjects::initializeVertices(MapPortionChunks& chunks,
+                                    MapTextureAtlas& atlas, int squareSize,
+                                    QHash<int, MapTexture*>& characters,
                                     int &spritesOffset)
 {
-    clearSprites();
-    m_vertices.clear();
-    m_indexes.clear();
+    int count = MapPortionChunks::count();
+    QVector<QMap<int, MapPortionGeometry>> sprites(count);
+    QVector<MapPortionGeometry> squares(count);
 
-    // Objects and their squares
-    int count = 0;
+    // Objects and their squares in the dirty chunks
     QHash<Position, SystemCommonObject*>::iterator i;
     for (i = m_all.begin(); i != m_all.end(); i++){
         Position position = i.key();
+        int chunk = chunks.index(position.x(), position.z());
+        if (!chunks.isDirty(chunk))
+            continue;
         SystemCommonObject* o = i.value();
         SystemState* state = o->getFirstState();
 
         // Draw the first state graphics of the object
         if (state != nullptr) {
             int graphicsId = state->graphicsId();
-            QOpenGLTexture* texture = characters[graphicsId];
+            MapTexture* texture = characters.value(graphicsId);
 
-            // If texture ID doesn't exist, load empty texture
+            // If texture ID doesn't exist, load empty texture. The hash is
+            // shared by the loader threads: it must not be modified here
             if (texture == nullptr){
                 graphicsId = -1;
-                texture = characters[graphicsId];
+                texture = characters.value(graphicsId);
             }
 
-            // Create the sprite geometry
+            // Create the sprite geometry, grouped by texture
             int frames = Wanok::get()->project()->gameDatas()->systemDatas()
                     ->framesAnimation();
             int width = texture->width() / frames / squareSize;
             int height = texture->height() / frames / squareSize;
             SpriteDatas sprite(
                         state->graphicsKind(), 50, 0,
-                        new QRect(state->indexX() * width,
-                                  state->indexY() * height,
-                                  width, height));
-            SpriteObject* spriteObject = new SpriteObject(sprite, texture);
-            spriteObject->initializeVertices(squareSize, position,
-                                             spritesOffset);
-
-            // Adding the sprite to the GL list
-            QHash<int, QList<SpriteObject*>*>& hash =
-                    (state->graphicsKind() ==
-                    MapEditorSubSelectionKind::SpritesFace) ? m_spritesFaceGL
-                                                            : m_spritesStaticGL;
-            if (hash.value(graphicsId) == nullptr)
-               hash[graphicsId] = new QList<SpriteObject*>;
-            hash[graphicsId]->append(spriteObject);
+                        QRect(state->indexX() * width,
+                              state->indexY() * height, width, height));
+            MapPortionGeometry& geometry = sprites[chunk][graphicsId];
+            sprite.initializeVertices(squareSize, texture->width(),
+                                      texture->height(),
+                                      geometry.verticesStatic,
+                                      geometry.indexesStatic,
+                                      geometry.verticesFace, position,
+                                      geometry.countStatic, spritesOffset);
         }
 
         // Draw the square of the object
+        MapPortionGeometry& geometry = squares[chunk];
         QVector3D pos(position.x() * squareSize, 0.1f,
                       position.z() * squareSize);
         QVector3D size(squareSize, 0.0, squareSize);
         float x = 0.0, y = 0.0, w = 1.0, h = 1.0;
-        m_vertices.append(Vertex(Floor::verticesQuad[0] * size + pos,
-                          QVector2D(x, y)));
-        m_vertices.append(Vertex(Floor::verticesQuad[1] * size + pos,
-                          QVector2D(x + w, y)));
-        m_vertices.append(Vertex(Floor::verticesQuad[2] * size + pos,
-                          QVector2D(x + w, y + h)));
-        m_vertices.append(Vertex(Floor::verticesQuad[3] * size + pos,
-                          QVector2D(x, y + h)));
-        int offset = count * Floor::nbVerticesQuad;
+        geometry.verticesStatic.append(
+                    Vertex(Floor::verticesQuad[0] * size + pos,
+                           QVector2D(x, y)));
+        geometry.verticesStatic.append(
+                    Vertex(Floor::verticesQuad[1] * size + pos,
+                           QVector2D(x + w, y)));
+        geometry.verticesStatic.append(
+                    Vertex(Floor::verticesQuad[2] * size + pos,
+                           QVector2D(x + w, y + h)));
+        geometry.verticesStatic.append(
+                    Vertex(Floor::verticesQuad[3] * size + pos,
+                           QVector2D(x, y + h)));
+        int offset = geometry.countStatic * Floor::nbVerticesQuad;
         for (int i = 0; i < Floor::nbIndexesQuad; i++)
-            m_indexes.append(Floor::indexesQuad[i] + offset);
-
-        count++;
-    }
-}
+            geometry.indexesStatic.append(Floor::indexesQuad[i] + offset);
 
-// -------------------------------------------------------
-
-void MapObjects::initializeGL(QOpenGLShaderProgram *programStatic,
-                              QOpenGLShaderProgram *programFace)
-{
-    QHash<int, QList<SpriteObject*>*>::const_iterator i;
-    for (i = m_spritesStaticGL.begin(); i != m_spritesStaticGL.end(); i++){
-        QList<SpriteObject*>* list = i.value();
-        for (int j = 0; j < list->size(); j++)
-            list->at(j)->initializeStaticGL(programStatic);
-    }
-    QHash<int, QList<SpriteObject*>*>::const_iterator j;
-    for (j = m_spritesFaceGL.begin(); j != m_spritesFaceGL.end(); j++){
-        QList<SpriteObject*>* list = j.value();
-        for (int i = 0; i < list->size(); i++)
-            list->at(i)->initializeFaceGL(programFace);
-    }
-
-    if (m_programStatic == nullptr){
-        initializeOpenGLFunctions();
-
-        // Programs
-        m_programStatic = programStatic;
-    }
-}
-
-// -------------------------------------------------------
-
-void MapObjects::updateGL(){
-
-    // Objects
-    QHash<int, QList<SpriteObject*>*>::const_iterator i;
-    for (i = m_spritesStaticGL.begin(); i != m_spritesStaticGL.end(); i++){
-        QList<SpriteObject*>* list = i.value();
-        for (int j = 0; j < list->size(); j++)
-            list->at(j)->updateStaticGL();
-    }
-    QHash<int, QList<SpriteObject*>*>::const_iterator j;
-    for (j = m_spritesFaceGL.begin(); j != m_spritesFaceGL.end(); j++){
-        QList<SpriteObject*>* list = j.value();
-        for (int i = 0; i < list->size(); i++)
-            list->at(i)->updateFaceGL();
+        geometry.countStatic++;
     }
 
-    // Squares of objects
-    Map::updateGLStatic(m_vertexBuffer, m_indexBuffer, m_vertices, m_indexes,
-                        m_vao, m_programStatic);
-}
-
-// -------------------------------------------------------
-
-void MapObjects::paintStaticSprites(int textureID, QOpenGLTexture *texture){
-    QList<SpriteObject*>* list = m_spritesStaticGL.value(textureID);
-
-    if (list != nullptr){
-        texture->bind();
-        for (int i = 0; i < list->size(); i++)
-            list->at(i)->paintGL();
-    }
-}
-
-// -------------------------------------------------------
-
-void MapObjects::paintFaceSprites(int textureID, QOpenGLTexture* texture){
-    QList<SpriteObject*>* list = m_spritesFaceGL.value(textureID);
-
-    if (list != nullptr){
-        texture->bind();
-        for (int i = 0; i < list->size(); i++)
-            list->at(i)->paintGL();
+    for (int k = 0; k < count; k++) {
+        if (!chunks.isDirty(k))
+            continue;
+        for (QMap<int, MapPortionGeometry>::iterator j = sprites[k].begin();
+             j != sprites[k].end(); j++)
+        {
+            if (atlas.contains(PictureKind::Characters, j.key())) {
+                j.value().mapTexCoords(atlas.rect(PictureKind::Characters,
+                                                  j.key()));
+                chunks.add(k, MapPortionRangeKind::Objects, j.key(),
+                           MapPortionRangeKind::Atlas, -1, j.value());
+            }
+            else {
+                chunks.add(k, MapPortionRangeKind::Objects, j.key(),
+                           MapPortionRangeKind::Objects, j.key(), j.value());
+            }
+        }
+        chunks.add(k, MapPortionRangeKind::ObjectsSquares, -1,
+                   MapPortionRangeKind::ObjectsSquares, -1, squares[k]);
     }
 }
 
-// -------------------------------------------------------
-
-void MapObjects::paintSquares(){
-    m_vao.bind();
-    glDrawElements(GL_TRIANGLES, m_indexes.size(), GL_UNSIGNED_INT, 0);
-    m_vao.bind();
-}
-
 // -------------------------------------------------------
 //
 //  READ / WRITE
@@ -340,3 +270,38 @@ void MapObjects::write(QJsonObject & json) const{
     }
     json["list"] = tab;
 }
+
+// -------------------------------------------------------
+
+void MapObjects::readBinary(QDataStream& stream, const BinaryPalette& palette){
+    quint32 count, objectIndex;
+
+    // Objects are kept as compact json in the strings palette
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+        Position p;
+        p.readBinary(stream);
+        stream >> objectIndex;
+        SystemCommonObject* o = new SystemCommonObject;
+        o->read(QJsonDocument::fromJson(palette.string(objectIndex).toUtf8())
+                .object());
+        m_all.insert(p, o);
+    }
+}
+
+// -------------------------------------------------------
+
+void MapObjects::writeBinary(QDataStream& stream, BinaryPalette& palette) const
+{
+    stream << (quint32) m_all.size();
+
+    QHash<Position, SystemCommonObject*>::const_iterator i;
+    for (i = m_all.begin(); i != m_all.end(); i++){
+        QJsonObject objValueObject;
+        i.value()->write(objValueObject);
+        i.key().writeBinary(stream);
+        stream << palette.stringIndex(QString::fromUtf8(
+                    QJsonDocument(objValueObject).toJson(
+                        QJsonDocument::Compact)));
+    }
+}
@@ -22,11 +22,6 @@
 
 #include <QHash>
 #include <QPair>
-#include <QOpenGLFunctions>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLBuffer>
-#include <QOpenGLVertexArrayObject>
-#include <QOpenGLTexture>
 #include "serializable.h"
 #include "position.h"
 #include "systemcommonobject.h"
@@ -41,12 +36,13 @@
 //
 // -------------------------------------------------------
 
-class MapObjects : protected QOpenGLFunctions, public Serializable
+class MapObjects : public Serializable, public BinarySerializable
 {
 public:
     MapObjects();
     virtual ~MapObjects();
     bool isEmpty() const;
+    qint64 memorySize() const;
     SystemCommonObject* getObjectAt(Position& p) const;
     void setObject(Position& p, SystemCommonObject* object);
     SystemCommonObject* removeObject(Position& p);
@@ -56,32 +52,19 @@ public:
     void removeObjectsOut(QList<int> &listDeletedObjectsIDs,
                           MapProperties& properties);
 
-    void clearSprites();
-    void initializeVertices(int squareSize,
-                            QHash<int, QOpenGLTexture *> &characters,
+    void initializeVertices(MapPortionChunks& chunks, MapTextureAtlas& atlas,
+                            int squareSize,
+                            QHash<int, MapTexture*>& characters,
                             int& spritesOffset);
-    void initializeGL(QOpenGLShaderProgram* programStatic,
-                      QOpenGLShaderProgram *programFace);
-    void updateGL();
-    void paintStaticSprites(int textureID, QOpenGLTexture* texture);
-    void paintFaceSprites(int textureID, QOpenGLTexture* texture);
-    void paintSquares();
+    void getCharactersUsed(QSet<int>& characters) const;
 
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject &json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 private:
     QHash<Position, SystemCommonObject*> m_all;
-    QHash<int, QList<SpriteObject*>*> m_spritesStaticGL;
-    QHash<int, QList<SpriteObject*>*> m_spritesFaceGL;
-
-    // OpenGL informations
-    QOpenGLBuffer m_vertexBuffer;
-    QOpenGLBuffer m_indexBuffer;
-    QVector<Vertex> m_vertices;
-    QVector<GLuint> m_indexes;
-    QOpenGLVertexArrayObject m_vao;
-    QOpenGLShaderProgram* m_programStatic;
 };
 
 #endif // MAPOBJECTS_H
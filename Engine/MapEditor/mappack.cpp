@@ -0,0 +1,334 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include "mappack.h"
+#include "wanok.h"
+
+// "RPMK" read as a little endian integer
+const quint32 MapPack::MAGIC = 0x4B4D5052;
+const quint16 MapPack::VERSION = 1;
+const int MapPack::HEADER_SIZE = 32;
+const int MapPack::INDEX_ENTRY_SIZE = 24;
+const qint64 MapPack::COMPACT_MIN_SIZE = 1024 * 1024;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPack::MapPack(QString pathMap) :
+    m_path(Wanok::pathCombine(pathMap, Wanok::FILE_MAP_PACK)),
+    m_data(nullptr),
+    m_size(0)
+{
+
+}
+
+MapPack::~MapPack()
+{
+    close();
+}
+
+QString MapPack::path() const { return m_path; }
+
+int MapPack::count() const { return m_index.size(); }
+
+bool MapPack::contains(Portion& portion) {
+    open();
+
+    return m_index.contains(portion);
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+bool MapPack::open() {
+    if (m_data != nullptr && !isOutdated())
+        return true;
+
+    close();
+    QFileInfo info(m_path);
+    if (!info.exists())
+        return false;
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+    m_size = m_file.size();
+    m_lastModified = info.lastModified();
+    m_data = m_file.map(0, m_size);
+    if (m_data == nullptr || !readIndex(m_data, m_size)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapPack::close() {
+    if (m_data != nullptr)
+        m_file.unmap(m_data);
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_index.clear();
+}
+
+// -------------------------------------------------------
+
+bool MapPack::readPortion(Portion& portion, BinarySerializable& obj) {
+    if (!open())
+        return false;
+
+    QHash<Portion, MapPackEntry>::const_iterator it = m_index.find(portion);
+    if (it == m_index.end())
+        return false;
+
+    // Read directly from the memory map, without any copy
+    QByteArray data = QByteArray::fromRawData(
+                reinterpret_cast<const char*>(m_data + it.value().offset),
+                it.value().length);
+
+    return Wanok::readBinaryData(data, obj);
+}
+
+// -------------------------------------------------------
+
+void MapPack::setPortion(Portion& portion, const QByteArray& data) {
+    m_portionsToRemove.removeAll(portion);
+    m_portionsToWrite.insert(portion, data);
+}
+
+// -------------------------------------------------------
+
+void MapPack::removePortion(Portion& portion) {
+    m_portionsToWrite.remove(portion);
+    if (!m_portionsToRemove.contains(portion))
+        m_portionsToRemove.append(portion);
+}
+
+// -------------------------------------------------------
+
+bool MapPack::commit() {
+    if (m_portionsToWrite.isEmpty() && m_portionsToRemove.isEmpty())
+        return true;
+
+    // A pack that exists but can't be read is left untouched, instead of
+    // losing all its portions
+    QFileInfo info(m_path);
+    bool isNew = !info.exists() || info.size() < HEADER_SIZE;
+    if (!isNew && !open())
+        return false;
+
+    // The memory map has to be released before writing in the file
+    QHash<Portion, MapPackEntry> index = m_index;
+    close();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+    if (isNew) {
+        file.resize(0);
+        writeHeader(file, 0, 0);
+    }
+    for (int i = 0; i < m_portionsToRemove.size(); i++)
+        index.remove(m_portionsToRemove.at(i));
+
+    // Append the new versions of portions
+    file.seek(file.size());
+    for (QHash<Portion, QByteArray>::const_iterator i =
+         m_portionsToWrite.begin(); i != m_portionsToWrite.end(); i++)
+    {
+        MapPackEntry entry;
+        entry.offset = file.pos();
+        entry.length = i.value().size();
+        if (file.write(i.value()) != i.value().size())
+            return false;
+        index.insert(i.key(), entry);
+    }
+
+    // Append the new index, and only then make the header point to it
+    m_index = index;
+    quint64 indexOffset = file.pos();
+    writeIndex(file);
+    if (!file.flush())
+        return false;
+    file.seek(0);
+    writeHeader(file, indexOffset, m_index.size());
+    if (!file.flush())
+        return false;
+    qint64 size = file.size();
+    file.close();
+    m_portionsToWrite.clear();
+    m_portionsToRemove.clear();
+
+    // Compact if more than half of the file is made of old versions
+    if (size > COMPACT_MIN_SIZE && liveSize() * 2 < size)
+        compact();
+    m_index.clear();
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+bool MapPack::compact() {
+    if (!open())
+        return false;
+
+    // Portions are copied one after the other, so the index position is
+    // known before writing anything
+    QHash<Portion, MapPackEntry> index;
+    quint64 offset = HEADER_SIZE;
+    for (QHash<Portion, MapPackEntry>::const_iterator i = m_index.begin();
+         i != m_index.end(); i++)
+    {
+        MapPackEntry entry;
+        entry.offset = offset;
+        entry.length = i.value().length;
+        offset += entry.length;
+        index.insert(i.key(), entry);
+    }
+
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    writeHeader(file, offset, index.size());
+    for (QHash<Portion, MapPackEntry>::const_iterator i = m_index.begin();
+         i != m_index.end(); i++)
+    {
+        file.write(reinterpret_cast<const char*>(m_data + i.value().offset),
+                   i.value().length);
+    }
+    m_index = index;
+    writeIndex(file);
+
+    // The memory map has to be released before replacing the file
+    close();
+
+    return file.commit();
+}
+
+// -------------------------------------------------------
+
+bool MapPack::isOutdated() const {
+    QFileInfo info(m_path);
+
+    return !info.exists() || info.size() != m_size ||
+            info.lastModified() != m_lastModified;
+}
+
+// -------------------------------------------------------
+
+qint64 MapPack::liveSize() const {
+    qint64 size = HEADER_SIZE + m_index.size() * INDEX_ENTRY_SIZE;
+    for (QHash<Portion, MapPackEntry>::const_iterator i = m_index.begin();
+         i != m_index.end(); i++)
+    {
+        size += i.value().length;
+    }
+
+    return size;
+}
+
+// -------------------------------------------------------
+//
+//  READ / WRITE
+//
+// -------------------------------------------------------
+
+bool MapPack::readIndex(const uchar* data, qint64 size) {
+    if (size < HEADER_SIZE)
+        return false;
+
+    quint32 magic, indexCount;
+    quint16 version, flags;
+    quint64 indexOffset;
+    QByteArray header = QByteArray::fromRawData(
+                reinterpret_cast<const char*>(data), HEADER_SIZE);
+    QDataStream stream(header);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream >> magic >> version >> flags >> indexOffset >> indexCount;
+    if (magic != MAGIC || version > VERSION || indexOffset > (quint64) size ||
+        (quint64) indexCount * INDEX_ENTRY_SIZE >
+        (quint64) size - indexOffset)
+    {
+        return false;
+    }
+
+    // Index
+    qint32 x, y, z;
+    m_index.clear();
+    QByteArray tab = QByteArray::fromRawData(
+                reinterpret_cast<const char*>(data + indexOffset),
+                indexCount * INDEX_ENTRY_SIZE);
+    QDataStream streamIndex(tab);
+    streamIndex.setByteOrder(QDataStream::LittleEndian);
+    for (quint32 i = 0; i < indexCount; i++) {
+        MapPackEntry entry;
+        streamIndex >> x >> y >> z >> entry.offset >> entry.length;
+        if (entry.offset > (quint64) size ||
+            entry.length > (quint64) size - entry.offset)
+        {
+            return false;
+        }
+        m_index.insert(Portion(x, y, z), entry);
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapPack::writeHeader(QIODevice& device, quint64 indexOffset,
+                          quint32 indexCount) const
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << MAGIC << VERSION << (quint16) 0 << indexOffset << indexCount;
+
+    // Reserved
+    header.append(QByteArray(HEADER_SIZE - header.size(), 0));
+    device.write(header);
+}
+
+// -------------------------------------------------------
+
+void MapPack::writeIndex(QIODevice& device) const {
+    QByteArray tab;
+    QDataStream stream(&tab, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    for (QHash<Portion, MapPackEntry>::const_iterator i = m_index.begin();
+         i != m_index.end(); i++)
+    {
+        stream << (qint32) i.key().x() << (qint32) i.key().y()
+               << (qint32) i.key().z() << i.value().offset
+               << i.value().length;
+    }
+    device.write(tab);
+}
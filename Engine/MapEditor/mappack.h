@@ -0,0 +1,95 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPACK_H
+#define MAPPACK_H
+
+#include <QFile>
+#include <QDateTime>
+#include <QHash>
+#include "portion.h"
+#include "binaryserializable.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapPackEntry
+//
+//  The location of a portion inside a map pack file.
+//
+// -------------------------------------------------------
+
+struct MapPackEntry
+{
+    quint64 offset;
+    quint32 length;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPack
+//
+//  All the binary portions of a map stored in a single file. The
+//  header points to an index (offset, length) of every portion. The
+//  file is read through a memory map, and new versions of portions
+//  are appended with a new index before the header is updated, so
+//  that the previous index stays valid until the very last write.
+//
+// -------------------------------------------------------
+
+class MapPack
+{
+public:
+    MapPack(QString pathMap);
+    virtual ~MapPack();
+    const static quint32 MAGIC;
+    const static quint16 VERSION;
+    const static int HEADER_SIZE;
+    const static int INDEX_ENTRY_SIZE;
+    const static qint64 COMPACT_MIN_SIZE;
+
+    QString path() const;
+    int count() const;
+    bool contains(Portion& portion);
+    bool open();
+    void close();
+    bool readPortion(Portion& portion, BinarySerializable& obj);
+    void setPortion(Portion& portion, const QByteArray& data);
+    void removePortion(Portion& portion);
+    bool commit();
+    bool compact();
+
+protected:
+    QString m_path;
+    QFile m_file;
+    uchar* m_data;
+    qint64 m_size;
+    QDateTime m_lastModified;
+    QHash<Portion, MapPackEntry> m_index;
+    QHash<Portion, QByteArray> m_portionsToWrite;
+    QList<Portion> m_portionsToRemove;
+
+    bool isOutdated() const;
+    bool readIndex(const uchar* data, qint64 size);
+    void writeHeader(QIODevice& device, quint64 indexOffset,
+                     quint32 indexCount) const;
+    void writeIndex(QIODevice& device) const;
+    qint64 liveSize() const;
+};
+
+#endif // MAPPACK_H
@@ -27,20 +27,26 @@
 
 MapPortion::MapPortion(Portion &globalPortion) :
     m_globalPortion(globalPortion),
-    m_floors(new Floors),
+    m_floors(new Floors(globalPortion)),
     m_sprites(new Sprites),
-    m_mapObjects(new MapObjects)
+    m_mapObjects(new MapObjects),
+    m_buffer(new MapPortionBuffer),
+    m_chunks(new MapPortionChunks(globalPortion)),
+    m_isLoaded(false)
 {
 
 }
 
 MapPortion::~MapPortion()
 {
+    // The preview marks its chunks as dirty: clear it before the chunks
+    clearPreview();
+
     delete m_floors;
     delete m_sprites;
     delete m_mapObjects;
-
-    clearPreview();
+    delete m_buffer;
+    delete m_chunks;
 }
 
 void MapPortion::getGlobalPortion(Portion& portion) {
@@ -49,22 +55,12 @@ void MapPortion::getGlobalPortion(Portion& portion) {
 
 MapObjects* MapPortion::mapObjects() const { return m_mapObjects; }
 
-bool MapPortion::isVisibleLoaded() const {
-    return isVisible();
-}
-
-bool MapPortion::isVisible() const {
-   return m_isVisible;
-}
+MapPortionBuffer* MapPortion::buffer() const { return m_buffer; }
 
 bool MapPortion::isLoaded() const {
     return m_isLoaded;
 }
 
-void MapPortion::setIsVisible(bool b) {
-    m_isVisible = b;
-}
-
 void MapPortion::setIsLoaded(bool b) {
     m_isLoaded = b;
 }
@@ -74,23 +70,39 @@ bool MapPortion::isEmpty() const {
             m_mapObjects->isEmpty();
 }
 
+qint64 MapPortion::memorySize() const {
+    return sizeof(MapPortion) + m_floors->memorySize() +
+            m_sprites->memorySize() + m_mapObjects->memorySize() +
+            m_buffer->memorySize() + m_chunks->memorySize();
+}
+
+void MapPortion::getTexturesUsed(QSet<int>& characters, QSet<int>& walls) const
+{
+    m_mapObjects->getCharactersUsed(characters);
+    m_sprites->getWallsUsed(walls);
+}
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
 //
 // -------------------------------------------------------
 
-LandDatas* MapPortion::getLand(Position& p){
-    return m_floors->getLand(p);
+MapEditorSubSelectionKind MapPortion::getLand(Position& p, QRect& texture){
+    return m_floors->getLand(p, texture);
 }
 
 bool MapPortion::addLand(Position& p, LandDatas *land){
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_floors->addLand(p, land);
 }
 
 // -------------------------------------------------------
 
 bool MapPortion::deleteLand(Position& p){
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_floors->deleteLand(p);
 }
 
@@ -98,8 +110,10 @@ bool MapPortion::deleteLand(Position& p){
 
 bool MapPortion::addSprite(QSet<Portion>& portionsOverflow, Position& p,
                            MapEditorSubSelectionKind kind, int widthPosition,
-                           int angle, QRect *textureRect)
+                           int angle, const QRect& textureRect)
 {
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_sprites->addSprite(portionsOverflow, p, kind, widthPosition, angle,
                                 textureRect);
 }
@@ -107,24 +121,33 @@ bool MapPortion::addSprite(QSet<Portion>& portionsOverflow, Position& p,
 // -------------------------------------------------------
 
 bool MapPortion::deleteSprite(QSet<Portion> &portionsOverflow, Position& p){
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_sprites->deleteSprite(portionsOverflow, p);
 }
 
 // -------------------------------------------------------
 
 bool MapPortion::addSpriteWall(GridPosition& gridPosition, int specialID) {
+    m_chunks->setDirty(gridPosition);
+
     return m_sprites->addSpriteWall(gridPosition, specialID);
 }
 
 // -------------------------------------------------------
 
 bool MapPortion::deleteSpriteWall(GridPosition& gridPosition) {
+    m_chunks->setDirty(gridPosition);
+
     return m_sprites->deleteSpriteWall(gridPosition);
 }
 
 // -------------------------------------------------------
 
 void MapPortion::updateSpriteWalls() {
+
+    // The shape of a wall depends on its neighbors, in any chunk
+    m_chunks->setAllDirty();
     m_sprites->updateSpriteWalls(m_previewGrid, m_previewDeleteGrid);
 }
 
@@ -138,12 +161,16 @@ SpriteWallDatas* MapPortion::getWallAt(GridPosition& gridPosition) {
 // -------------------------------------------------------
 
 bool MapPortion::addObject(Position& p, SystemCommonObject* o){
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_mapObjects->addObject(p, o);
 }
 
 // -------------------------------------------------------
 
 bool MapPortion::deleteObject(Position& p){
+    m_chunks->setDirty(p.x(), p.z());
+
     return m_mapObjects->deleteObject(p);
 }
 
@@ -162,12 +189,14 @@ void MapPortion::removeOverflow(Position& p) {
 // -------------------------------------------------------
 
 void MapPortion::removeLandOut(MapProperties& properties) {
+    m_chunks->setAllDirty();
     m_floors->removeLandOut(properties);
 }
 
 // -------------------------------------------------------
 
 void MapPortion::removeSpritesOut(MapProperties& properties) {
+    m_chunks->setAllDirty();
     m_sprites->removeSpritesOut(properties);
 }
 
@@ -176,19 +205,39 @@ void MapPortion::removeSpritesOut(MapProperties& properties) {
 void MapPortion::removeObjectsOut(QList<int> &listDeletedObjectsIDs,
                                   MapProperties& properties)
 {
+    m_chunks->setAllDirty();
     m_mapObjects->removeObjectsOut(listDeletedObjectsIDs, properties);
 }
 
 // -------------------------------------------------------
 
+void MapPortion::clear() {
+    delete m_floors;
+    delete m_sprites;
+    delete m_mapObjects;
+    delete m_chunks;
+    m_floors = new Floors(m_globalPortion);
+    m_sprites = new Sprites;
+    m_mapObjects = new MapObjects;
+    m_chunks = new MapPortionChunks(m_globalPortion);
+}
+
+// -------------------------------------------------------
+
 void MapPortion::clearPreview() {
     QHash<Position, MapElement*>::iterator i;
-    for (i = m_previewSquares.begin(); i != m_previewSquares.end(); i++)
+    for (i = m_previewSquares.begin(); i != m_previewSquares.end(); i++) {
+        m_chunks->setDirty(i.key().x(), i.key().z());
         delete i.value();
+    }
 
     QHash<GridPosition, MapElement*>::iterator j;
-    for (j = m_previewGrid.begin(); j != m_previewGrid.end(); j++)
+    for (j = m_previewGrid.begin(); j != m_previewGrid.end(); j++) {
+        m_chunks->setDirty(j.key());
         delete j.value();
+    }
+    for (int k = 0; k < m_previewDeleteGrid.size(); k++)
+        m_chunks->setDirty(m_previewDeleteGrid.at(k));
 
     m_previewSquares.clear();
     m_previewGrid.clear();
@@ -198,18 +247,21 @@ void MapPortion::clearPreview() {
 // -------------------------------------------------------
 
 void MapPortion::addPreview(Position& p, MapElement* element) {
+    m_chunks->setDirty(p.x(), p.z());
     m_previewSquares.insert(p, element);
 }
 
 // -------------------------------------------------------
 
 void MapPortion::addPreviewGrid(GridPosition& p, MapElement* element) {
+    m_chunks->setDirty(p);
     m_previewGrid.insert(p, element);
 }
 
 // -------------------------------------------------------
 
 void MapPortion::addPreviewDeleteGrid(GridPosition& p) {
+    m_chunks->setDirty(p);
     m_previewDeleteGrid.append(p);
 }
 
@@ -247,18 +299,30 @@ void MapPortion::updateRaycastingOverflowSprite(int squareSize,
 // -------------------------------------------------------
 
 
-void MapPortion::initializeVertices(int squareSize, QOpenGLTexture *tileset,
-                                    QHash<int, QOpenGLTexture *> &characters,
-                                    QHash<int, QOpenGLTexture *> &walls)
+void MapPortion::initializeVertices(int squareSize, MapTexture* tileset,
+                                    QHash<int, MapTexture*>& characters,
+                                    QHash<int, MapTexture*>& walls,
+                                    MapTextureAtlas& atlas)
 {
     int spritesOffset = -0.005;
-    m_floors->initializeVertices(m_previewSquares, squareSize,
+
+    m_chunks->setGeneration(atlas.generation());
+    if (!m_chunks->hasDirty())
+        return;
+
+    // Only the dirty chunks are built, then the ranges of all the chunks
+    // are added in the order they are drawn
+    m_chunks->removeDirty();
+    m_floors->initializeVertices(*m_chunks, m_previewSquares, squareSize,
                                  tileset->width(), tileset->height());
-    m_sprites->initializeVertices(walls, m_previewSquares, m_previewGrid,
-                                  m_previewDeleteGrid, squareSize,
-                                  tileset->width(), tileset->height(),
-                                  spritesOffset);
-    m_mapObjects->initializeVertices(squareSize, characters, spritesOffset);
+    m_sprites->initializeVertices(*m_chunks, atlas, walls, m_previewSquares,
+                                  m_previewGrid, m_previewDeleteGrid,
+                                  squareSize, tileset->width(),
+                                  tileset->height(), spritesOffset);
+    m_mapObjects->initializeVertices(*m_chunks, atlas, squareSize,
+                                     characters, spritesOffset);
+    m_buffer->clear();
+    m_chunks->fill(*m_buffer);
 }
 
 // -------------------------------------------------------
@@ -266,63 +330,13 @@ void MapPortion::initializeVertices(int squareSize, QOpenGLTexture *tileset,
 void MapPortion::initializeGL(QOpenGLShaderProgram *programStatic,
                               QOpenGLShaderProgram *programFace)
 {
-    m_floors->initializeGL(programStatic);
-    m_sprites->initializeGL(programStatic, programFace);
-    m_mapObjects->initializeGL(programStatic, programFace);
+    m_buffer->initializeGL(programStatic, programFace);
 }
 
 // -------------------------------------------------------
 
 void MapPortion::updateGL(){
-    m_floors->updateGL();
-    m_sprites->updateGL();
-    m_mapObjects->updateGL();
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintFloors(){
-    m_floors->paintGL();
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintSprites(){
-    m_sprites->paintGL();
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintSpritesWalls(int textureID) {
-    m_sprites->paintSpritesWalls(textureID);
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintFaceSprites(){
-    m_sprites->paintFaceGL();
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintObjectsStaticSprites(int textureID,
-                                           QOpenGLTexture* texture)
-{
-    m_mapObjects->paintStaticSprites(textureID, texture);
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintObjectsFaceSprites(int textureID,
-                                         QOpenGLTexture* texture)
-{
-    m_mapObjects->paintFaceSprites(textureID, texture);
-}
-
-// -------------------------------------------------------
-
-void MapPortion::paintObjectsSquares(){
-    m_mapObjects->paintSquares();
+    m_buffer->updateGL();
 }
 
 // -------------------------------------------------------
@@ -358,3 +372,21 @@ void MapPortion::write(QJsonObject & json) const{
     m_mapObjects->write(obj);
     json["objs"] = obj;
 }
+
+// -------------------------------------------------------
+
+void MapPortion::readBinary(QDataStream& stream, const BinaryPalette& palette)
+{
+    m_floors->readBinary(stream, palette);
+    m_sprites->readBinary(stream, palette);
+    m_mapObjects->readBinary(stream, palette);
+}
+
+// -------------------------------------------------------
+
+void MapPortion::writeBinary(QDataStream& stream, BinaryPalette& palette) const
+{
+    m_floors->writeBinary(stream, palette);
+    m_sprites->writeBinary(stream, palette);
+    m_mapObjects->writeBinary(stream, palette);
+}
@@ -24,36 +24,38 @@
 #include "sprites.h"
 #include "mapobjects.h"
 #include "systemcommonobject.h"
-#include <QOpenGLTexture>
+#include "maptexture.h"
+#include "mapportionbuffer.h"
+#include "mapportionchunks.h"
 
 // -------------------------------------------------------
 //
 //  CLASS MapPortion
 //
 //  A portion of the map. The map is divided in a lot of portions
-//  in order to perform 3D drawing.
+//  in order to perform 3D drawing. Each edit marks its chunk of the
+//  portion as dirty, so that only this chunk is built again.
 //
 // -------------------------------------------------------
 
-class MapPortion : public Serializable
+class MapPortion : public Serializable, public BinarySerializable
 {
 public:
     MapPortion(Portion& globalPortion);
     virtual ~MapPortion();
     void getGlobalPortion(Portion& portion);
     MapObjects* mapObjects() const;
-    bool isVisibleLoaded() const;
-    bool isVisible() const;
+    MapPortionBuffer* buffer() const;
     bool isLoaded() const;
-    void setIsVisible(bool b);
     void setIsLoaded(bool b);
     bool isEmpty() const;
-    LandDatas* getLand(Position& p);
+    qint64 memorySize() const;
+    MapEditorSubSelectionKind getLand(Position& p, QRect& texture);
     bool addLand(Position& p, LandDatas* land);
     bool deleteLand(Position& p);
     bool addSprite(QSet<Portion>& portionsOverflow, Position& p,
                    MapEditorSubSelectionKind kind, int widthPosition, int angle,
-                   QRect *textureRect);
+                   const QRect& textureRect);
     bool deleteSprite(QSet<Portion>& portionsOverflow, Position& p);
     bool addSpriteWall(GridPosition& gridPosition, int specialID);
     bool deleteSpriteWall(GridPosition& gridPosition);
@@ -67,6 +69,7 @@ public:
     void removeSpritesOut(MapProperties& properties);
     void removeObjectsOut(QList<int>& listDeletedObjectsIDs,
                           MapProperties& properties);
+    void clear();
     void clearPreview();
     void addPreview(Position& p, MapElement* element);
     void addPreviewGrid(GridPosition& p, MapElement* element);
@@ -79,32 +82,34 @@ public:
                                         Position &finalPosition, QRay3D& ray,
                                         double cameraHAngle);
 
-    void initializeVertices(int squareSize, QOpenGLTexture* tileset,
-                            QHash<int, QOpenGLTexture*>& characters,
-                            QHash<int, QOpenGLTexture *> &walls);
+    void getTexturesUsed(QSet<int>& characters, QSet<int>& walls) const;
+
+    void initializeVertices(int squareSize, MapTexture* tileset,
+                            QHash<int, MapTexture*>& characters,
+                            QHash<int, MapTexture*>& walls,
+                            MapTextureAtlas& atlas);
     void initializeGL(QOpenGLShaderProgram *programStatic,
                       QOpenGLShaderProgram *programFace);
     void updateGL();
-    void paintFloors();
-    void paintSprites();
-    void paintSpritesWalls(int textureID);
-    void paintFaceSprites();
-    void paintObjectsStaticSprites(int textureID, QOpenGLTexture* texture);
-    void paintObjectsFaceSprites(int textureID, QOpenGLTexture* texture);
-    void paintObjectsSquares();
 
     void read(const QJsonObject &json);
     void write(QJsonObject &json) const;
+    void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 private:
     Portion m_globalPortion;
     Floors* m_floors;
     Sprites* m_sprites;
     MapObjects* m_mapObjects;
+    MapPortionBuffer* m_buffer;
+    MapPortionChunks* m_chunks;
+
+    // Preview elements are allocated by the editor, never in the pools of
+    // the portion, and deleted by clearPreview()
     QHash<Position, MapElement*> m_previewSquares;
     QHash<GridPosition, MapElement*> m_previewGrid;
     QList<GridPosition> m_previewDeleteGrid;
-    bool m_isVisible;
     bool m_isLoaded;
 };
 
@@ -0,0 +1,509 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <QOpenGLContext>
+#include "mapportionbuffer.h"
+
+const int MapPortionBuffer::MIN_CAPACITY = 64;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPortionGeometry::MapPortionGeometry() :
+    countStatic(0)
+{
+
+}
+
+void MapPortionGeometry::mapTexCoords(const QRectF& rect) {
+    QVector2D tex;
+    QVector4D texRect;
+
+    for (int i = 0; i < verticesStatic.size(); i++) {
+        tex = verticesStatic.at(i).tex();
+        verticesStatic[i].setTex(QVector2D(rect.x() + tex.x() * rect.width(),
+                                           rect.y() + tex.y() *
+                                           rect.height()));
+    }
+    for (int i = 0; i < verticesFace.size(); i++) {
+        texRect = verticesFace.at(i).texRect();
+        verticesFace[i].setTexRect(QVector4D(
+                                       rect.x() + texRect.x() * rect.width(),
+                                       rect.y() + texRect.y() * rect.height(),
+                                       texRect.z() * rect.width(),
+                                       texRect.w() * rect.height()));
+    }
+}
+
+// -------------------------------------------------------
+
+MapPortionBuffer::MapPortionBuffer() :
+    m_isUploaded(false),
+    m_vertexBuffer(QOpenGLBuffer::VertexBuffer),
+    m_indexBuffer(QOpenGLBuffer::IndexBuffer),
+    m_programStatic(nullptr),
+    m_programFace(nullptr),
+    m_isInstanced(false),
+    m_offsetFace(0),
+    m_firstFaceAttributes(0),
+    m_capacityStatic(0),
+    m_capacityIndexes(0),
+    m_capacityFace(0)
+{
+
+}
+
+MapPortionBuffer::~MapPortionBuffer()
+{
+
+}
+
+bool MapPortionBuffer::isEmpty() const {
+    return m_indexesStatic.isEmpty() && m_verticesFace.isEmpty();
+}
+
+qint64 MapPortionBuffer::memorySize() const {
+    return m_verticesStatic.size() * sizeof(Vertex) +
+            m_verticesFace.size() * sizeof(VertexBillboard) +
+            m_indexesStatic.size() * sizeof(GLuint) +
+            (m_rangesStatic.size() + m_rangesFace.size()) *
+            sizeof(MapPortionRange);
+}
+
+const QBox3D& MapPortionBuffer::box() const { return m_box; }
+
+const QList<MapPortionRange>& MapPortionBuffer::rangesStatic() const {
+    return m_rangesStatic;
+}
+
+const QList<MapPortionRange>& MapPortionBuffer::rangesFace() const {
+    return m_rangesFace;
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapPortionBuffer::clear() {
+
+    // Keep what is in the GL buffers to only upload the differences
+    if (m_isUploaded) {
+        m_previousStatic.swap(m_verticesStatic);
+        m_previousIndexes.swap(m_indexesStatic);
+        m_previousFace.swap(m_verticesFace);
+        m_isUploaded = false;
+    }
+    m_verticesStatic.clear();
+    m_indexesStatic.clear();
+    m_rangesStatic.clear();
+    m_verticesFace.clear();
+    m_rangesFace.clear();
+    m_box.setToNull();
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::addStatic(MapPortionRangeKind kind, int textureID,
+                                 const QVector<Vertex>& vertices,
+                                 const QVector<GLuint>& indexes)
+{
+    if (indexes.isEmpty())
+        return;
+
+    GLuint offset = m_verticesStatic.size();
+    m_verticesStatic += vertices;
+    for (int i = 0; i < vertices.size(); i++)
+        m_box.unite(vertices.at(i).position());
+    addRange(m_rangesStatic, kind, textureID, m_indexesStatic.size(),
+             indexes.size());
+    for (int i = 0; i < indexes.size(); i++)
+        m_indexesStatic.append(indexes.at(i) + offset);
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::addFace(MapPortionRangeKind kind, int textureID,
+                               const QVector<VertexBillboard>& vertices)
+{
+    if (vertices.isEmpty())
+        return;
+
+    addRange(m_rangesFace, kind, textureID, m_verticesFace.size(),
+             vertices.size());
+    m_verticesFace += vertices;
+
+    // A face sprite turns around the y axis, so its half width is used
+    // in both x and z
+    for (int i = 0; i < vertices.size(); i++) {
+        const VertexBillboard& vertex = vertices.at(i);
+        QVector3D extent(vertex.size().x() / 2, vertex.size().y() / 2,
+                         vertex.size().x() / 2);
+        m_box.unite(vertex.centerPosition() - extent);
+        m_box.unite(vertex.centerPosition() + extent);
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::add(MapPortionRangeKind kind, int textureID,
+                           const MapPortionGeometry& geometry)
+{
+    addStatic(kind, textureID, geometry.verticesStatic,
+              geometry.indexesStatic);
+    addFace(kind, textureID, geometry.verticesFace);
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::addRange(QList<MapPortionRange>& ranges,
+                                MapPortionRangeKind kind, int textureID,
+                                int offset, int count)
+{
+    // Consecutive elements with the same texture are drawn at once
+    if (!ranges.isEmpty()) {
+        MapPortionRange& last = ranges.last();
+        if (last.kind == kind && last.textureID == textureID &&
+            last.offset + last.count == offset)
+        {
+            last.count += count;
+            return;
+        }
+    }
+
+    MapPortionRange range;
+    range.kind = kind;
+    range.textureID = textureID;
+    range.offset = offset;
+    range.count = count;
+    ranges.append(range);
+}
+
+int MapPortionBuffer::getCapacity(int count) {
+    return qMax(MIN_CAPACITY, count + count / 2);
+}
+
+// -------------------------------------------------------
+
+bool MapPortionBuffer::getChangedSpan(const void* previous, int previousCount,
+                                      const void* current, int currentCount,
+                                      int elementSize, int& first, int& end)
+{
+    const char* bytesPrevious = static_cast<const char*>(previous);
+    const char* bytesCurrent = static_cast<const char*>(current);
+    int count = qMin(previousCount, currentCount);
+
+    first = 0;
+    while (first < count && memcmp(bytesPrevious + first * elementSize,
+                                   bytesCurrent + first * elementSize,
+                                   elementSize) == 0)
+    {
+        first++;
+    }
+    if (first == currentCount)
+        return false;
+
+    // The new elements at the end always have to be written
+    end = currentCount;
+    if (currentCount <= previousCount) {
+        while (end - 1 > first &&
+               memcmp(bytesPrevious + (end - 1) * elementSize,
+                      bytesCurrent + (end - 1) * elementSize,
+                      elementSize) == 0)
+        {
+            end--;
+        }
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------
+//
+//  GL
+//
+// -------------------------------------------------------
+
+bool MapPortionBuffer::isInstancingSupported() {
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+
+    // glVertexAttribDivisor is core since GL 3.3 and GL ES 3.0
+    return context != nullptr && context->format().version() >=
+            (context->isOpenGLES() ? qMakePair(3, 0) : qMakePair(3, 3));
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::initializeGL(QOpenGLShaderProgram* programStatic,
+                                    QOpenGLShaderProgram* programFace)
+{
+    if (m_programStatic == nullptr){
+        initializeOpenGLFunctions();
+        m_isInstanced = isInstancingSupported();
+
+        // Programs
+        m_programStatic = programStatic;
+        m_programFace = programFace;
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::createGL() {
+    m_vertexBuffer.create();
+    m_vertexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_indexBuffer.create();
+    m_indexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+
+    // Static VAO
+    m_vertexBuffer.bind();
+    m_programStatic->bind();
+    m_vaoStatic.create();
+    m_vaoStatic.bind();
+    m_programStatic->enableAttributeArray(0);
+    m_programStatic->enableAttributeArray(1);
+    m_programStatic->setAttributeBuffer(0, GL_FLOAT,
+                                        Vertex::positionOffset(),
+                                        Vertex::positionTupleSize,
+                                        Vertex::stride());
+    m_programStatic->setAttributeBuffer(1, GL_FLOAT,
+                                        Vertex::texOffset(),
+                                        Vertex::texCoupleSize,
+                                        Vertex::stride());
+    m_indexBuffer.bind();
+    m_vaoStatic.release();
+    m_indexBuffer.release();
+    m_programStatic->release();
+
+    // Face VAO, no index: the shader finds the corners with gl_VertexID.
+    // The attributes are set once the place of the billboards is known
+    m_programFace->bind();
+    m_vaoFace.create();
+    m_vaoFace.bind();
+    m_programFace->enableAttributeArray(0);
+    m_programFace->enableAttributeArray(1);
+    m_programFace->enableAttributeArray(2);
+    if (m_isInstanced) {
+        glVertexAttribDivisor(0, 1);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+    }
+    m_vaoFace.release();
+    m_programFace->release();
+    m_vertexBuffer.release();
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::updateGL() {
+    int first, end;
+
+    if (m_isUploaded)
+        return;
+    if (!m_vertexBuffer.isCreated()) {
+        if (isEmpty())
+            return;
+        createGL();
+    }
+
+    // Vertices: the static ones, followed by the billboards
+    m_vertexBuffer.bind();
+    if (m_verticesStatic.size() > m_capacityStatic ||
+        m_verticesFace.size() > m_capacityFace)
+    {
+        int repeat = m_isInstanced ? 1 : VertexBillboard::verticesCount;
+        m_capacityStatic = getCapacity(m_verticesStatic.size());
+        m_capacityFace = getCapacity(m_verticesFace.size());
+        m_offsetFace = m_capacityStatic * sizeof(Vertex);
+        m_vertexBuffer.allocate(m_offsetFace + m_capacityFace * repeat *
+                                sizeof(VertexBillboard));
+        writeStatic(0, m_verticesStatic.size());
+        writeFace(0, m_verticesFace.size());
+
+        // The billboards moved in the buffer
+        m_vaoFace.bind();
+        setFaceAttributes(0);
+        m_vaoFace.release();
+    }
+    else {
+        if (getChangedSpan(m_previousStatic.constData(),
+                           m_previousStatic.size(),
+                           m_verticesStatic.constData(),
+                           m_verticesStatic.size(), sizeof(Vertex), first,
+                           end))
+        {
+            writeStatic(first, end);
+        }
+        if (getChangedSpan(m_previousFace.constData(), m_previousFace.size(),
+                           m_verticesFace.constData(), m_verticesFace.size(),
+                           sizeof(VertexBillboard), first, end))
+        {
+            writeFace(first, end);
+        }
+    }
+    m_vertexBuffer.release();
+
+    // Indexes
+    m_indexBuffer.bind();
+    if (m_indexesStatic.size() > m_capacityIndexes) {
+        m_capacityIndexes = getCapacity(m_indexesStatic.size());
+        m_indexBuffer.allocate(m_capacityIndexes * sizeof(GLuint));
+        writeIndexes(0, m_indexesStatic.size());
+    }
+    else if (getChangedSpan(m_previousIndexes.constData(),
+                            m_previousIndexes.size(),
+                            m_indexesStatic.constData(),
+                            m_indexesStatic.size(), sizeof(GLuint), first,
+                            end))
+    {
+        writeIndexes(first, end);
+    }
+    m_indexBuffer.release();
+
+    m_previousStatic.clear();
+    m_previousIndexes.clear();
+    m_previousFace.clear();
+    m_isUploaded = true;
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::writeStatic(int first, int end) {
+    if (first >= end)
+        return;
+
+    m_vertexBuffer.write(first * sizeof(Vertex),
+                         m_verticesStatic.constData() + first,
+                         (end - first) * sizeof(Vertex));
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::writeIndexes(int first, int end) {
+    if (first >= end)
+        return;
+
+    m_indexBuffer.write(first * sizeof(GLuint),
+                        m_indexesStatic.constData() + first,
+                        (end - first) * sizeof(GLuint));
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::writeFace(int first, int end) {
+    if (first >= end)
+        return;
+
+    if (m_isInstanced) {
+        m_vertexBuffer.write(m_offsetFace + first * sizeof(VertexBillboard),
+                             m_verticesFace.constData() + first,
+                             (end - first) * sizeof(VertexBillboard));
+        return;
+    }
+
+    // Each billboard is repeated for the 6 vertices of its quad
+    int repeat = VertexBillboard::verticesCount;
+    QVector<VertexBillboard> vertices;
+    vertices.reserve((end - first) * repeat);
+    for (int i = first; i < end; i++) {
+        for (int j = 0; j < repeat; j++)
+            vertices.append(m_verticesFace.at(i));
+    }
+    m_vertexBuffer.write(m_offsetFace + first * repeat *
+                         sizeof(VertexBillboard), vertices.constData(),
+                         vertices.size() * sizeof(VertexBillboard));
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::setFaceAttributes(int first) {
+    int offset = m_offsetFace + first * VertexBillboard::stride();
+    m_programFace->setAttributeBuffer(
+                0, GL_FLOAT, offset + VertexBillboard::positionOffset(),
+                VertexBillboard::positionTupleSize, VertexBillboard::stride());
+    m_programFace->setAttributeBuffer(
+                1, GL_FLOAT, offset + VertexBillboard::texRectOffset(),
+                VertexBillboard::texRectTupleSize, VertexBillboard::stride());
+    m_programFace->setAttributeBuffer(
+                2, GL_FLOAT, offset + VertexBillboard::sizeOffset(),
+                VertexBillboard::sizeCoupleSize, VertexBillboard::stride());
+    m_firstFaceAttributes = first;
+}
+
+// -------------------------------------------------------
+
+bool MapPortionBuffer::bindStatic() {
+    if (!m_isUploaded || m_indexesStatic.isEmpty())
+        return false;
+    m_vaoStatic.bind();
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+bool MapPortionBuffer::bindFace() {
+    if (!m_isUploaded || m_verticesFace.isEmpty())
+        return false;
+    m_vaoFace.bind();
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::paintStatic(const MapPortionRange& range) {
+    glDrawElements(GL_TRIANGLES, range.count, GL_UNSIGNED_INT,
+                   reinterpret_cast<void*>(range.offset * sizeof(GLuint)));
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::paintFace(const MapPortionRange& range) {
+    if (!m_isInstanced) {
+        glDrawArrays(GL_TRIANGLES,
+                     range.offset * VertexBillboard::verticesCount,
+                     range.count * VertexBillboard::verticesCount);
+        return;
+    }
+
+    // Without base instance, the attributes are moved to the first
+    // billboard of the range
+    if (range.offset != m_firstFaceAttributes) {
+        m_vertexBuffer.bind();
+        setFaceAttributes(range.offset);
+        m_vertexBuffer.release();
+    }
+    glDrawArraysInstanced(GL_TRIANGLES, 0, VertexBillboard::verticesCount,
+                          range.count);
+}
+
+// -------------------------------------------------------
+
+void MapPortionBuffer::release() {
+    if (m_vaoStatic.isCreated())
+        m_vaoStatic.release();
+    if (m_vaoFace.isCreated())
+        m_vaoFace.release();
+}
@@ -0,0 +1,166 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPORTIONBUFFER_H
+#define MAPPORTIONBUFFER_H
+
+#include <QList>
+#include <QVector>
+#include <QRectF>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include "vertex.h"
+#include "vertexbillboard.h"
+#include "mapportionrangekind.h"
+#include "qbox3d.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionGeometry
+//
+//  The vertices of elements using the same texture, built before
+//  being added to the buffer of a portion. Indexes start at 0, and
+//  there is one billboard per face sprite.
+//
+// -------------------------------------------------------
+
+struct MapPortionGeometry
+{
+    MapPortionGeometry();
+    void mapTexCoords(const QRectF& rect);
+
+    QVector<Vertex> verticesStatic;
+    QVector<GLuint> indexesStatic;
+    QVector<VertexBillboard> verticesFace;
+    int countStatic;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionRange
+//
+//  A range of indexes, or of billboards, drawn with the same texture.
+//
+// -------------------------------------------------------
+
+struct MapPortionRange
+{
+    MapPortionRangeKind kind;
+    int textureID;
+    int offset;
+    int count;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionBuffer
+//
+//  All the geometry of a portion in one vertex buffer and one index
+//  buffer. The static vertices are followed by the billboards, and
+//  each of them has its own VAO pointing in the shared vertex buffer.
+//  The ranges tables tell which part uses which texture. The box
+//  bounding all the vertices is kept for frustum culling.
+//
+//  The buffers are allocated with some headroom and the VAOs are
+//  created once. An update only writes the span of elements that
+//  differs from the previous upload, and the storage is allocated
+//  again only when it is too small.
+//
+//  A billboard is drawn as an instance of a quad built by the shader.
+//  Without instanced arrays (GL < 3.3), each billboard is repeated for
+//  the 6 vertices of its quad instead.
+//
+// -------------------------------------------------------
+
+class MapPortionBuffer : protected QOpenGLExtraFunctions
+{
+public:
+    MapPortionBuffer();
+    virtual ~MapPortionBuffer();
+    const static int MIN_CAPACITY;
+    bool isEmpty() const;
+    qint64 memorySize() const;
+    const QBox3D& box() const;
+    const QList<MapPortionRange>& rangesStatic() const;
+    const QList<MapPortionRange>& rangesFace() const;
+
+    void clear();
+    void addStatic(MapPortionRangeKind kind, int textureID,
+                   const QVector<Vertex>& vertices,
+                   const QVector<GLuint>& indexes);
+    void addFace(MapPortionRangeKind kind, int textureID,
+                 const QVector<VertexBillboard>& vertices);
+    void add(MapPortionRangeKind kind, int textureID,
+             const MapPortionGeometry& geometry);
+
+    void initializeGL(QOpenGLShaderProgram* programStatic,
+                      QOpenGLShaderProgram* programFace);
+    void updateGL();
+    bool bindStatic();
+    bool bindFace();
+    void paintStatic(const MapPortionRange& range);
+    void paintFace(const MapPortionRange& range);
+    void release();
+
+protected:
+    QVector<Vertex> m_verticesStatic;
+    QVector<GLuint> m_indexesStatic;
+    QList<MapPortionRange> m_rangesStatic;
+    QVector<VertexBillboard> m_verticesFace;
+    QList<MapPortionRange> m_rangesFace;
+    QBox3D m_box;
+
+    // Content of the GL buffers, kept until the next upload
+    QVector<Vertex> m_previousStatic;
+    QVector<GLuint> m_previousIndexes;
+    QVector<VertexBillboard> m_previousFace;
+    bool m_isUploaded;
+
+    // OpenGL informations
+    QOpenGLBuffer m_vertexBuffer;
+    QOpenGLBuffer m_indexBuffer;
+    QOpenGLVertexArrayObject m_vaoStatic;
+    QOpenGLVertexArrayObject m_vaoFace;
+    QOpenGLShaderProgram* m_programStatic;
+    QOpenGLShaderProgram* m_programFace;
+    bool m_isInstanced;
+    int m_offsetFace;
+    int m_firstFaceAttributes;
+    int m_capacityStatic;
+    int m_capacityIndexes;
+    int m_capacityFace;
+
+    static bool isInstancingSupported();
+    static void addRange(QList<MapPortionRange>& ranges,
+                         MapPortionRangeKind kind, int textureID,
+                         int offset, int count);
+    static int getCapacity(int count);
+    static bool getChangedSpan(const void* previous, int previousCount,
+                               const void* current, int currentCount,
+                               int elementSize, int& first, int& end);
+    void createGL();
+    void writeStatic(int first, int end);
+    void writeIndexes(int first, int end);
+    void writeFace(int first, int end);
+    void setFaceAttributes(int first);
+};
+
+#endif // MAPPORTIONBUFFER_H
@@ -0,0 +1,121 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mapportioncache.h"
+#include "mapportion.h"
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPortionCache::MapPortionCache() :
+    m_memory(0),
+    m_hits(0),
+    m_misses(0)
+{
+
+}
+
+MapPortionCache::~MapPortionCache()
+{
+    clear();
+}
+
+int MapPortionCache::count() const { return m_entries.size(); }
+
+qint64 MapPortionCache::memory() const { return m_memory; }
+
+quint64 MapPortionCache::hits() const { return m_hits; }
+
+quint64 MapPortionCache::misses() const { return m_misses; }
+
+bool MapPortionCache::contains(Portion& portion) const {
+    return m_entries.contains(portion);
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+MapPortion* MapPortionCache::take(Portion& portion) {
+    QHash<Portion, MapPortionCacheEntry>::iterator it =
+            m_entries.find(portion);
+    if (it == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+
+    MapPortion* mapPortion = it.value().mapPortion;
+    m_memory -= it.value().size;
+    m_entries.erase(it);
+    m_recentlyUsed.removeOne(portion);
+    m_hits++;
+
+    return mapPortion;
+}
+
+// -------------------------------------------------------
+
+void MapPortionCache::insert(Portion& portion, MapPortion* mapPortion,
+                             qint64 budget)
+{
+    remove(portion);
+
+    MapPortionCacheEntry entry;
+    entry.mapPortion = mapPortion;
+    entry.size = mapPortion->memorySize();
+    m_entries.insert(portion, entry);
+    m_recentlyUsed.append(portion);
+    m_memory += entry.size;
+
+    // The oldest portions are deleted first, even the one just inserted
+    while (m_memory > budget && !m_recentlyUsed.isEmpty()) {
+        Portion oldest = m_recentlyUsed.first();
+        remove(oldest);
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionCache::remove(Portion& portion) {
+    QHash<Portion, MapPortionCacheEntry>::iterator it =
+            m_entries.find(portion);
+    if (it == m_entries.end())
+        return;
+
+    m_memory -= it.value().size;
+    delete it.value().mapPortion;
+    m_entries.erase(it);
+    m_recentlyUsed.removeOne(portion);
+}
+
+// -------------------------------------------------------
+
+void MapPortionCache::clear() {
+    QHash<Portion, MapPortionCacheEntry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); it++)
+        delete it.value().mapPortion;
+    m_entries.clear();
+    m_recentlyUsed.clear();
+    m_memory = 0;
+}
@@ -0,0 +1,77 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPORTIONCACHE_H
+#define MAPPORTIONCACHE_H
+
+#include <QHash>
+#include "portion.h"
+
+class MapPortion;
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionCacheEntry
+//
+//  A portion kept in the cache with its estimated memory size.
+//
+// -------------------------------------------------------
+
+struct MapPortionCacheEntry
+{
+    MapPortion* mapPortion;
+    qint64 size;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionCache
+//
+//  Decoded portions outside of the loaded window: the ones evicted by
+//  the cursor moves and the prefetched ones. They keep their vertices
+//  and their buffers, so that coming back to them is only a pointer
+//  move. The least recently used portions are deleted when the memory
+//  budget is exceeded. The cache owns its portions.
+//
+// -------------------------------------------------------
+
+class MapPortionCache
+{
+public:
+    MapPortionCache();
+    virtual ~MapPortionCache();
+    int count() const;
+    qint64 memory() const;
+    quint64 hits() const;
+    quint64 misses() const;
+    bool contains(Portion& portion) const;
+    MapPortion* take(Portion& portion);
+    void insert(Portion& portion, MapPortion* mapPortion, qint64 budget);
+    void remove(Portion& portion);
+    void clear();
+
+protected:
+    QHash<Portion, MapPortionCacheEntry> m_entries;
+    QList<Portion> m_recentlyUsed;
+    qint64 m_memory;
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+#endif // MAPPORTIONCACHE_H
@@ -0,0 +1,164 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mapportionchunks.h"
+#include "wanok.h"
+
+const int MapPortionChunks::CHUNK_SIZE = 4;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPortionChunks::MapPortionChunks(Portion& globalPortion) :
+    m_originX(globalPortion.x() * Wanok::portionSize),
+    m_originZ(globalPortion.z() * Wanok::portionSize),
+    m_generation(-1),
+    m_dirty(count(), true),
+    m_slots(count())
+{
+
+}
+
+MapPortionChunks::~MapPortionChunks()
+{
+
+}
+
+int MapPortionChunks::countSide() {
+    return (Wanok::portionSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+int MapPortionChunks::count() {
+    return countSide() * countSide();
+}
+
+int MapPortionChunks::index(int x, int z) const {
+    int side = countSide();
+
+    // Walls on the border of the portion go in the closest chunk
+    x = qBound(0, (x - m_originX) / CHUNK_SIZE, side - 1);
+    z = qBound(0, (z - m_originZ) / CHUNK_SIZE, side - 1);
+
+    return z * side + x;
+}
+
+bool MapPortionChunks::isDirty(int chunk) const {
+    return m_dirty.testBit(chunk);
+}
+
+bool MapPortionChunks::hasDirty() const {
+    return m_dirty.count(true) > 0;
+}
+
+qint64 MapPortionChunks::memorySize() const {
+    qint64 size = 0;
+    for (int i = 0; i < m_slots.size(); i++) {
+        for (QMap<QPair<int, int>, MapPortionSlot>::const_iterator j =
+             m_slots.at(i).begin(); j != m_slots.at(i).end(); j++)
+        {
+            const MapPortionGeometry& geometry = j.value().geometry;
+            size += sizeof(MapPortionSlot) +
+                    geometry.verticesStatic.size() * sizeof(Vertex) +
+                    geometry.indexesStatic.size() * sizeof(GLuint) +
+                    geometry.verticesFace.size() * sizeof(VertexBillboard);
+        }
+    }
+
+    return size;
+}
+
+void MapPortionChunks::setDirty(int x, int z) {
+    m_dirty.setBit(index(x, z));
+}
+
+void MapPortionChunks::setDirty(const GridPosition& position) {
+    setDirty(position.x1(), position.z1());
+    setDirty(position.x2(), position.z2());
+}
+
+void MapPortionChunks::setAllDirty() {
+    m_dirty.fill(true);
+}
+
+// -------------------------------------------------------
+
+void MapPortionChunks::setGeneration(int generation) {
+
+    // The texture coordinates depend on the textures
+    if (m_generation != generation) {
+        m_generation = generation;
+        setAllDirty();
+    }
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapPortionChunks::removeDirty() {
+    for (int i = 0; i < m_slots.size(); i++) {
+        if (isDirty(i))
+            m_slots[i].clear();
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionChunks::add(int chunk, MapPortionRangeKind section, int key,
+                           MapPortionRangeKind kind, int textureID,
+                           const MapPortionGeometry& geometry)
+{
+    if (geometry.verticesStatic.isEmpty() && geometry.verticesFace.isEmpty())
+        return;
+
+    MapPortionSlot& slot = m_slots[chunk][QPair<int, int>((int) section,
+                                                          key)];
+    slot.kind = kind;
+    slot.textureID = textureID;
+    slot.geometry = geometry;
+}
+
+// -------------------------------------------------------
+
+void MapPortionChunks::fill(MapPortionBuffer& buffer) {
+    QMap<QPair<int, int>, QList<const MapPortionSlot*>> slots;
+
+    // The chunks keep their order inside each slot
+    for (int i = 0; i < m_slots.size(); i++) {
+        for (QMap<QPair<int, int>, MapPortionSlot>::const_iterator j =
+             m_slots.at(i).begin(); j != m_slots.at(i).end(); j++)
+        {
+            slots[j.key()].append(&j.value());
+        }
+    }
+    for (QMap<QPair<int, int>, QList<const MapPortionSlot*>>::const_iterator
+         i = slots.begin(); i != slots.end(); i++)
+    {
+        for (int j = 0; j < i.value().size(); j++) {
+            const MapPortionSlot* slot = i.value().at(j);
+            buffer.add(slot->kind, slot->textureID, slot->geometry);
+        }
+    }
+    m_dirty.fill(false);
+}
@@ -0,0 +1,91 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPORTIONCHUNKS_H
+#define MAPPORTIONCHUNKS_H
+
+#include <QBitArray>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include "portion.h"
+#include "gridposition.h"
+#include "mapportionbuffer.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionSlot
+//
+//  The geometry of a chunk for one range of the buffer.
+//
+// -------------------------------------------------------
+
+struct MapPortionSlot
+{
+    MapPortionRangeKind kind;
+    int textureID;
+    MapPortionGeometry geometry;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionChunks
+//
+//  The vertices of a portion, split in columns of CHUNK_SIZE x
+//  CHUNK_SIZE squares. An edit marks the chunk of its square as
+//  dirty, and only the dirty chunks are built again. The slots are
+//  sorted by (section, key), the section being the kind of element
+//  and the key a layer or a texture ID. They are added to the buffer
+//  slot after slot in this order, so the ranges of the chunks using
+//  the same texture stay merged.
+//
+// -------------------------------------------------------
+
+class MapPortionChunks
+{
+public:
+    MapPortionChunks(Portion& globalPortion);
+    virtual ~MapPortionChunks();
+    const static int CHUNK_SIZE;
+
+    static int countSide();
+    static int count();
+    int index(int x, int z) const;
+    bool isDirty(int chunk) const;
+    bool hasDirty() const;
+    qint64 memorySize() const;
+    void setDirty(int x, int z);
+    void setDirty(const GridPosition& position);
+    void setAllDirty();
+    void setGeneration(int generation);
+    void removeDirty();
+    void add(int chunk, MapPortionRangeKind section, int key,
+             MapPortionRangeKind kind, int textureID,
+             const MapPortionGeometry& geometry);
+    void fill(MapPortionBuffer& buffer);
+
+protected:
+    int m_originX;
+    int m_originZ;
+    int m_generation;
+    QBitArray m_dirty;
+    QVector<QMap<QPair<int, int>, MapPortionSlot>> m_slots;
+};
+
+#endif // MAPPORTIONCHUNKS_H
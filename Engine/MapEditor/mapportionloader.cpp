@@ -0,0 +1,162 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mapportionloader.h"
+#include "threadmapportionloader.h"
+#include "mapportion.h"
+
+const int MapPortionLoader::MAX_THREADS = 4;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPortionLoader::MapPortionLoader(Map* map) :
+    m_jobsRunning(0),
+    m_stopping(false)
+{
+    // Keep a core for the GUI thread
+    int count = qBound(1, QThread::idealThreadCount() - 1, MAX_THREADS);
+    for (int i = 0; i < count; i++) {
+        ThreadMapPortionLoader* thread = new ThreadMapPortionLoader(map, this);
+        m_threads.append(thread);
+        thread->start(QThread::LowPriority);
+    }
+}
+
+MapPortionLoader::~MapPortionLoader()
+{
+    m_mutex.lock();
+    m_stopping = true;
+    m_portionsToLoad.clear();
+    m_conditionQueue.wakeAll();
+    m_mutex.unlock();
+
+    for (int i = 0; i < m_threads.size(); i++) {
+        m_threads.at(i)->wait();
+        delete m_threads.at(i);
+    }
+    for (int i = 0; i < m_portionsLoaded.size(); i++)
+        delete m_portionsLoaded.at(i);
+}
+
+int MapPortionLoader::queueDepth() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_portionsToLoad.size();
+}
+
+bool MapPortionLoader::isIdle() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_portionsToLoad.isEmpty() && m_portionsLoaded.isEmpty() &&
+            m_jobsRunning == 0;
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapPortionLoader::load(Portion& portion) {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_portionsToLoad.contains(portion)) {
+        m_portionsToLoad.append(portion);
+        m_conditionQueue.wakeOne();
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionLoader::cancelOutside(Portion& origin, int ray) {
+    QMutexLocker locker(&m_mutex);
+
+    for (int i = m_portionsToLoad.size() - 1; i >= 0; i--) {
+        const Portion& portion = m_portionsToLoad.at(i);
+        if (qAbs(portion.x() - origin.x()) > ray ||
+            qAbs(portion.y() - origin.y()) > ray ||
+            qAbs(portion.z() - origin.z()) > ray)
+        {
+            m_portionsToLoad.removeAt(i);
+        }
+    }
+}
+
+// -------------------------------------------------------
+
+void MapPortionLoader::cancelAll() {
+    QMutexLocker locker(&m_mutex);
+
+    m_portionsToLoad.clear();
+}
+
+// -------------------------------------------------------
+
+void MapPortionLoader::drain() {
+    QMutexLocker locker(&m_mutex);
+
+    m_portionsToLoad.clear();
+    while (m_jobsRunning > 0)
+        m_conditionIdle.wait(&m_mutex);
+
+    // Not uploaded yet, so there is no GL object to release
+    for (int i = 0; i < m_portionsLoaded.size(); i++)
+        delete m_portionsLoaded.at(i);
+    m_portionsLoaded.clear();
+}
+
+// -------------------------------------------------------
+
+MapPortion* MapPortionLoader::takeLoaded() {
+    QMutexLocker locker(&m_mutex);
+
+    return m_portionsLoaded.isEmpty() ? nullptr
+                                      : m_portionsLoaded.takeFirst();
+}
+
+// -------------------------------------------------------
+
+bool MapPortionLoader::takeJob(Portion& portion) {
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_stopping && m_portionsToLoad.isEmpty())
+        m_conditionQueue.wait(&m_mutex);
+    if (m_stopping)
+        return false;
+    portion = m_portionsToLoad.takeFirst();
+    m_jobsRunning++;
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapPortionLoader::finishJob(MapPortion* mapPortion) {
+    QMutexLocker locker(&m_mutex);
+
+    m_jobsRunning--;
+    if (mapPortion != nullptr)
+        m_portionsLoaded.append(mapPortion);
+    if (m_jobsRunning == 0)
+        m_conditionIdle.wakeAll();
+}
@@ -0,0 +1,73 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPORTIONLOADER_H
+#define MAPPORTIONLOADER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include "portion.h"
+
+class Map;
+class MapPortion;
+class ThreadMapPortionLoader;
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionLoader
+//
+//  The queue of portions streamed by the worker threads. Workers read
+//  the portion files and build the vertices, and the loaded portions
+//  wait here until the GUI thread uploads them with OpenGL. A canceled
+//  portion is only removed from the queue: a load already started is
+//  dropped by the map when it is not in the window anymore. Draining
+//  waits for the running loads and drops everything, before the map
+//  changes what the workers read.
+//
+// -------------------------------------------------------
+
+class MapPortionLoader
+{
+public:
+    MapPortionLoader(Map* map);
+    virtual ~MapPortionLoader();
+    const static int MAX_THREADS;
+
+    int queueDepth() const;
+    bool isIdle() const;
+    void load(Portion& portion);
+    void cancelOutside(Portion& origin, int ray);
+    void cancelAll();
+    void drain();
+    MapPortion* takeLoaded();
+    bool takeJob(Portion& portion);
+    void finishJob(MapPortion* mapPortion);
+
+protected:
+    QList<ThreadMapPortionLoader*> m_threads;
+    mutable QMutex m_mutex;
+    QWaitCondition m_conditionQueue;
+    QWaitCondition m_conditionIdle;
+    QList<Portion> m_portionsToLoad;
+    QList<MapPortion*> m_portionsLoaded;
+    int m_jobsRunning;
+    bool m_stopping;
+};
+
+#endif // MAPPORTIONLOADER_H
@@ -0,0 +1,199 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QFile>
+#include <QElapsedTimer>
+#include "mapportionwriter.h"
+
+const int MapPortionWriter::COALESCE_DELAY = 250;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapPortionWriter::MapPortionWriter() :
+    m_serial(0),
+    m_bytesWritten(0),
+    m_writesCount(0),
+    m_writesCoalesced(0),
+    m_flushing(0),
+    m_stopping(false)
+{
+    start(QThread::LowPriority);
+}
+
+MapPortionWriter::~MapPortionWriter()
+{
+    stop();
+    wait();
+}
+
+int MapPortionWriter::queueDepth() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_pending.size();
+}
+
+quint64 MapPortionWriter::bytesWritten() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_bytesWritten;
+}
+
+quint64 MapPortionWriter::writesCount() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_writesCount;
+}
+
+quint64 MapPortionWriter::writesCoalesced() const {
+    QMutexLocker locker(&m_mutex);
+
+    return m_writesCoalesced;
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapPortionWriter::write(QString path, const QByteArray& data) {
+    enqueue(path, data, false);
+}
+
+// -------------------------------------------------------
+
+void MapPortionWriter::remove(QString path) {
+    enqueue(path, QByteArray(), true);
+}
+
+// -------------------------------------------------------
+
+bool MapPortionWriter::pending(QString path, QByteArray& data,
+                               bool& remove) const
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, MapPortionWrite>::const_iterator it = m_pending.find(path);
+    if (it == m_pending.end())
+        return false;
+
+    data = it.value().data;
+    remove = it.value().remove;
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void MapPortionWriter::flush() {
+    QMutexLocker locker(&m_mutex);
+    if (!isRunning())
+        return;
+
+    m_flushing++;
+    m_conditionQueue.wakeAll();
+    while (!m_pending.isEmpty())
+        m_conditionFlushed.wait(&m_mutex);
+    m_flushing--;
+}
+
+// -------------------------------------------------------
+
+void MapPortionWriter::stop() {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_conditionQueue.wakeAll();
+}
+
+// -------------------------------------------------------
+
+void MapPortionWriter::enqueue(QString path, const QByteArray& data,
+                               bool remove)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.contains(path))
+        m_writesCoalesced++;
+
+    MapPortionWrite& write = m_pending[path];
+    write.data = data;
+    write.remove = remove;
+    write.serial = ++m_serial;
+    m_conditionQueue.wakeAll();
+}
+
+// -------------------------------------------------------
+
+void MapPortionWriter::run() {
+    QMutexLocker locker(&m_mutex);
+
+    while (true) {
+        while (m_pending.isEmpty() && !m_stopping)
+            m_conditionQueue.wait(&m_mutex);
+        if (m_pending.isEmpty())
+            break;
+
+        // Wait a little so that the next writes of a portion being
+        // painted replace this one
+        QElapsedTimer timer;
+        timer.start();
+        while (m_flushing == 0 && !m_stopping) {
+            qint64 left = COALESCE_DELAY - timer.elapsed();
+            if (left <= 0)
+                break;
+            m_conditionQueue.wait(&m_mutex, left);
+        }
+
+        // Write without locking so that the editor can still queue
+        QHash<QString, MapPortionWrite> writes = m_pending;
+        locker.unlock();
+        quint64 bytes = 0;
+        QHash<QString, MapPortionWrite>::const_iterator i;
+        for (i = writes.begin(); i != writes.end(); i++) {
+            if (i.value().remove)
+                QFile(i.key()).remove();
+            else {
+                QFile file(i.key());
+                if (file.open(QIODevice::WriteOnly)) {
+                    bytes += qMax(file.write(i.value().data), (qint64) 0);
+                    file.close();
+                }
+            }
+        }
+        locker.relock();
+
+        // Entries queued again during the writing need another pass
+        for (i = writes.begin(); i != writes.end(); i++) {
+            QHash<QString, MapPortionWrite>::iterator it =
+                    m_pending.find(i.key());
+            if (it != m_pending.end() &&
+                it.value().serial == i.value().serial)
+            {
+                m_pending.erase(it);
+            }
+        }
+        m_bytesWritten += bytes;
+        m_writesCount += writes.size();
+        if (m_pending.isEmpty())
+            m_conditionFlushed.wakeAll();
+    }
+    m_conditionFlushed.wakeAll();
+}
@@ -0,0 +1,90 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPORTIONWRITER_H
+#define MAPPORTIONWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include "singleton.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionWrite
+//
+//  A snapshot of a temp portion file waiting to be written.
+//
+// -------------------------------------------------------
+
+struct MapPortionWrite
+{
+    QByteArray data;
+    bool remove;
+    quint64 serial;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapPortionWriter
+//
+//  A thread writing the temp portion files behind the editor. Portions
+//  are serialized on the GUI thread and only the resulting bytes are
+//  queued here. Several writes of the same file during the coalescing
+//  delay are merged into the last one. flush() blocks until the queue
+//  is empty and must be called before reading or moving temp files.
+//
+// -------------------------------------------------------
+
+class MapPortionWriter : public QThread, public Singleton<MapPortionWriter>
+{
+    Q_OBJECT
+public:
+    MapPortionWriter();
+    virtual ~MapPortionWriter();
+    const static int COALESCE_DELAY;
+
+    int queueDepth() const;
+    quint64 bytesWritten() const;
+    quint64 writesCount() const;
+    quint64 writesCoalesced() const;
+    void write(QString path, const QByteArray& data);
+    void remove(QString path);
+    bool pending(QString path, QByteArray& data, bool& remove) const;
+    void flush();
+    void stop();
+
+protected:
+    mutable QMutex m_mutex;
+    QWaitCondition m_conditionQueue;
+    QWaitCondition m_conditionFlushed;
+    QHash<QString, MapPortionWrite> m_pending;
+    quint64 m_serial;
+    quint64 m_bytesWritten;
+    quint64 m_writesCount;
+    quint64 m_writesCoalesced;
+    int m_flushing;
+    bool m_stopping;
+
+    void enqueue(QString path, const QByteArray& data, bool remove);
+    void run();
+};
+
+#endif // MAPPORTIONWRITER_H
@@ -0,0 +1,174 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtConcurrent>
+#include "maptexture.h"
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapTexture::MapTexture(QString path) :
+    m_path(path),
+    m_isDecoding(false),
+    m_isDecoded(false),
+    m_texture(nullptr)
+{
+
+}
+
+MapTexture::MapTexture(const QImage& image) :
+    m_image(image),
+    m_size(image.size()),
+    m_isDecoding(false),
+    m_isDecoded(true),
+    m_texture(nullptr)
+{
+
+}
+
+MapTexture::~MapTexture()
+{
+    // A decoding task can't be cancelled once started
+    if (m_isDecoding)
+        m_future.waitForFinished();
+    if (m_texture != nullptr)
+        delete m_texture;
+}
+
+QString MapTexture::path() const { return m_path; }
+
+int MapTexture::width() {
+    QMutexLocker locker(&m_mutex);
+    waitDecoded();
+
+    return m_size.width();
+}
+
+int MapTexture::height() {
+    QMutexLocker locker(&m_mutex);
+    waitDecoded();
+
+    return m_size.height();
+}
+
+QImage MapTexture::image() {
+    QMutexLocker locker(&m_mutex);
+    waitDecoded();
+    QImage image = m_image;
+
+    // Null once uploaded, unless decodePixels() was called: these pixels
+    // are only kept until they are taken
+    if (m_texture != nullptr)
+        m_image = QImage();
+
+    return image;
+}
+
+bool MapTexture::isUploaded() {
+    QMutexLocker locker(&m_mutex);
+
+    return m_texture != nullptr;
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapTexture::decode() {
+    QMutexLocker locker(&m_mutex);
+    if (m_isDecoding || m_isDecoded)
+        return;
+
+    m_future = QtConcurrent::run(&MapTexture::decodeImage, m_path);
+    m_isDecoding = true;
+}
+
+// -------------------------------------------------------
+
+void MapTexture::decodePixels() {
+    QMutexLocker locker(&m_mutex);
+    if (m_texture == nullptr || !m_image.isNull() || m_isDecoding)
+        return;
+
+    m_future = QtConcurrent::run(&MapTexture::decodeImage, m_path);
+    m_isDecoding = true;
+    m_isDecoded = false;
+}
+
+// -------------------------------------------------------
+
+void MapTexture::waitDecoded() {
+    if (m_isDecoded)
+        return;
+
+    // Pictures that were not preloaded are decoded by the first caller
+    m_image = m_isDecoding ? m_future.result() : decodeImage(m_path);
+    m_future = QFuture<QImage>();
+    m_size = m_image.size();
+    m_isDecoding = false;
+    m_isDecoded = true;
+}
+
+// -------------------------------------------------------
+
+QImage MapTexture::decodeImage(QString path) {
+    QImage image;
+    if (!path.isEmpty())
+        image.load(path);
+
+    // Missing pictures are replaced by a transparent pixel
+    if (image.isNull()) {
+        image = QImage(1, 1, QImage::Format_ARGB32);
+        image.fill(QColor(0, 0, 0, 0));
+    }
+
+    return image;
+}
+
+// -------------------------------------------------------
+//
+//  GL
+//
+// -------------------------------------------------------
+
+QOpenGLTexture* MapTexture::texture() {
+    QMutexLocker locker(&m_mutex);
+    if (m_texture == nullptr) {
+        waitDecoded();
+        m_texture = new QOpenGLTexture(m_image);
+        m_texture->setMinificationFilter(QOpenGLTexture::Filter::Nearest);
+        m_texture->setMagnificationFilter(QOpenGLTexture::Filter::Nearest);
+
+        // The pixels are now on the GPU, only the size is still needed
+        m_image = QImage();
+    }
+
+    return m_texture;
+}
+
+// -------------------------------------------------------
+
+void MapTexture::bind() {
+    texture()->bind();
+}
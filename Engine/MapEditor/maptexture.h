@@ -0,0 +1,70 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPTEXTURE_H
+#define MAPTEXTURE_H
+
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QOpenGLTexture>
+
+// -------------------------------------------------------
+//
+//  CLASS MapTexture
+//
+//  A picture used by a map. The image can be decoded in the thread
+//  pool as soon as the map is opened, but it is only uploaded to the
+//  GPU the first time it is bound. The size is known without any GL
+//  call so that the loader threads can compute the vertices. Once
+//  uploaded, the pixels are only decoded again when an atlas needs them.
+//
+// -------------------------------------------------------
+
+class MapTexture
+{
+public:
+    MapTexture(QString path);
+    MapTexture(const QImage& image);
+    virtual ~MapTexture();
+    QString path() const;
+    int width();
+    int height();
+    QImage image();
+    bool isUploaded();
+    QOpenGLTexture* texture();
+    void decode();
+    void decodePixels();
+    void bind();
+
+protected:
+    QString m_path;
+    QMutex m_mutex;
+    QFuture<QImage> m_future;
+    QImage m_image;
+    QSize m_size;
+    bool m_isDecoding;
+    bool m_isDecoded;
+    QOpenGLTexture* m_texture;
+
+    void waitDecoded();
+    static QImage decodeImage(QString path);
+};
+
+#endif // MAPTEXTURE_H
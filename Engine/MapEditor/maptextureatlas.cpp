@@ -0,0 +1,183 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QPainter>
+#include <algorithm>
+#include "maptextureatlas.h"
+
+const int MapTextureAtlas::MIN_WIDTH = 512;
+const int MapTextureAtlas::MAX_SIZE = 4096;
+const int MapTextureAtlas::PADDING = 1;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapTextureAtlas::MapTextureAtlas() :
+    m_texture(nullptr),
+    m_isTextureCached(false),
+    m_generation(0)
+{
+
+}
+
+MapTextureAtlas::~MapTextureAtlas()
+{
+    clear();
+}
+
+bool MapTextureAtlas::isEmpty() const {
+    return m_texture == nullptr;
+}
+
+int MapTextureAtlas::generation() const { return m_generation; }
+
+bool MapTextureAtlas::contains(PictureKind kind, int id) const {
+    return m_texture != nullptr &&
+            m_rects.contains(QPair<int, int>((int) kind, id));
+}
+
+QRectF MapTextureAtlas::rect(PictureKind kind, int id) const {
+    return m_rects.value(QPair<int, int>((int) kind, id));
+}
+
+MapTexture* MapTextureAtlas::texture() const { return m_texture; }
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void MapTextureAtlas::clear() {
+
+    // The rects are kept to be compared with the ones of the next build
+    m_textures.clear();
+    if (m_texture != nullptr && !m_isTextureCached)
+        delete m_texture;
+    m_texture = nullptr;
+    m_isTextureCached = false;
+}
+
+// -------------------------------------------------------
+
+void MapTextureAtlas::add(PictureKind kind, int id, MapTexture* texture) {
+    m_textures.append(QPair<QPair<int, int>, MapTexture*>(
+                          QPair<int, int>((int) kind, id), texture));
+}
+
+// -------------------------------------------------------
+
+void MapTextureAtlas::build(MapTextureCache* cache) {
+    QHash<QPair<int, int>, QRectF> rectsPacked;
+
+    // The atlas of the previous map can be used as is
+    if (cache != nullptr)
+        m_texture = cache->atlas(m_textures, rectsPacked);
+    if (m_texture == nullptr) {
+        m_texture = pack(rectsPacked);
+        if (cache != nullptr && m_texture != nullptr)
+            cache->setAtlas(m_textures, m_texture, rectsPacked);
+    }
+    m_isTextureCached = cache != nullptr && m_texture != nullptr;
+    m_textures.clear();
+
+    // Same packing: the vertices already mapped are still right
+    if (rectsPacked != m_rects) {
+        m_rects = rectsPacked;
+        m_generation++;
+    }
+}
+
+// -------------------------------------------------------
+
+MapTexture* MapTextureAtlas::pack(QHash<QPair<int, int>, QRectF>&
+                                  rectsPacked)
+{
+    QList<QPair<QPair<int, int>, QImage>> images;
+    QList<QRect> rects;
+    int width = MIN_WIDTH;
+
+    // The pictures already uploaded alone are decoded again, in parallel
+    for (int i = 0; i < m_textures.size(); i++)
+        m_textures.at(i).second->decodePixels();
+    for (int i = 0; i < m_textures.size(); i++) {
+        QImage image = m_textures.at(i).second->image();
+        if (image.isNull() || image.width() + 2 * PADDING > MAX_SIZE)
+            continue;
+        images.append(QPair<QPair<int, int>, QImage>(m_textures.at(i).first,
+                                                     image));
+        while (width < image.width() + 2 * PADDING)
+            width *= 2;
+    }
+
+    // The tallest pictures first, so that shelves are filled evenly. The
+    // order of equal heights is kept, so the same pictures give the same
+    // packing
+    std::stable_sort(images.begin(), images.end(),
+              [](const QPair<QPair<int, int>, QImage>& a,
+                 const QPair<QPair<int, int>, QImage>& b)
+    {
+        return a.second.height() > b.second.height();
+    });
+
+    // Shelves
+    int x = 0, y = 0, shelfHeight = 0;
+    for (int i = 0; i < images.size(); i++) {
+        int w = images.at(i).second.width() + 2 * PADDING;
+        int h = images.at(i).second.height() + 2 * PADDING;
+        if (x + w > width) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + h > MAX_SIZE) {
+            images = images.mid(0, i);
+            break;
+        }
+        rects.append(QRect(x + PADDING, y + PADDING, w - 2 * PADDING,
+                           h - 2 * PADDING));
+        x += w;
+        shelfHeight = qMax(shelfHeight, h);
+    }
+
+    if (images.isEmpty())
+        return nullptr;
+
+    // Copy the pictures
+    int height = y + shelfHeight;
+    QImage atlas(width, height, QImage::Format_ARGB32);
+    atlas.fill(QColor(0, 0, 0, 0));
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int i = 0; i < images.size(); i++) {
+        const QRect& rect = rects.at(i);
+        painter.drawImage(rect.topLeft(), images.at(i).second);
+        rectsPacked.insert(images.at(i).first,
+                           QRectF((qreal) rect.x() / width,
+                                  (qreal) rect.y() / height,
+                                  (qreal) rect.width() / width,
+                                  (qreal) rect.height() / height));
+    }
+    painter.end();
+
+    return new MapTexture(atlas);
+}
@@ -0,0 +1,73 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPTEXTUREATLAS_H
+#define MAPTEXTUREATLAS_H
+
+#include <QHash>
+#include <QPair>
+#include <QRectF>
+#include "maptexturecache.h"
+#include "picturekind.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapTextureAtlas
+//
+//  The characters and walls pictures of a map packed in a single
+//  texture, so that the objects and the walls of a portion are drawn
+//  at once. The pictures are placed on shelves, with a transparent
+//  pixel around each of them. The texture coordinates of the vertices
+//  are mapped to the rect of their picture. A picture that doesn't
+//  fit keeps its own texture. The generation changes when a build
+//  packs the pictures differently, so that the vertices mapped with
+//  older rects are built again. With a texture cache, the atlas of the
+//  same pictures is shared instead of being built again.
+//
+// -------------------------------------------------------
+
+class MapTextureAtlas
+{
+public:
+    MapTextureAtlas();
+    virtual ~MapTextureAtlas();
+    const static int MIN_WIDTH;
+    const static int MAX_SIZE;
+    const static int PADDING;
+
+    bool isEmpty() const;
+    int generation() const;
+    bool contains(PictureKind kind, int id) const;
+    QRectF rect(PictureKind kind, int id) const;
+    MapTexture* texture() const;
+    void clear();
+    void add(PictureKind kind, int id, MapTexture* texture);
+    void build(MapTextureCache* cache = nullptr);
+
+protected:
+    QList<QPair<QPair<int, int>, MapTexture*>> m_textures;
+    QHash<QPair<int, int>, QRectF> m_rects;
+    MapTexture* m_texture;
+    bool m_isTextureCached;
+    int m_generation;
+
+    MapTexture* pack(QHash<QPair<int, int>, QRectF>& rectsPacked);
+};
+
+#endif // MAPTEXTUREATLAS_H
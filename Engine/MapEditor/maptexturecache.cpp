@@ -0,0 +1,160 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QFileInfo>
+#include "maptexturecache.h"
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+MapTextureCache::MapTextureCache() :
+    m_atlas(nullptr)
+{
+
+}
+
+MapTextureCache::~MapTextureCache()
+{
+    clear();
+}
+
+int MapTextureCache::count() const { return m_references.size(); }
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+MapTexture* MapTextureCache::acquire(PictureKind kind, int id, QString path) {
+    QPair<int, int> key((int) kind, id);
+    QDateTime lastModified = path.isEmpty() ? QDateTime()
+                                            : QFileInfo(path).lastModified();
+
+    QHash<QPair<int, int>, MapTextureCacheEntry>::iterator it =
+            m_entries.find(key);
+    if (it != m_entries.end()) {
+        MapTexture* texture = it.value().texture;
+        if (it.value().path == path &&
+            it.value().lastModified == lastModified)
+        {
+            m_references[texture]++;
+            return texture;
+        }
+
+        // The picture changed: maps still using the previous version keep
+        // it until they release it
+        m_entries.erase(it);
+        if (m_references.value(texture) == 0)
+            deleteTexture(texture);
+        else
+            m_outdated.insert(texture);
+    }
+
+    MapTextureCacheEntry entry;
+    entry.texture = new MapTexture(path);
+    entry.path = path;
+    entry.lastModified = lastModified;
+    m_entries.insert(key, entry);
+    m_references.insert(entry.texture, 1);
+
+    return entry.texture;
+}
+
+// -------------------------------------------------------
+
+void MapTextureCache::release(MapTexture* texture) {
+    QHash<MapTexture*, int>::iterator it = m_references.find(texture);
+    if (it == m_references.end())
+        return;
+
+    if (it.value() > 0)
+        it.value()--;
+    if (it.value() == 0 && m_outdated.contains(texture))
+        deleteTexture(texture);
+}
+
+// -------------------------------------------------------
+
+MapTexture* MapTextureCache::atlas(
+        const QList<QPair<QPair<int, int>, MapTexture*>>& textures,
+        QHash<QPair<int, int>, QRectF>& rects) const
+{
+    if (m_atlas == nullptr || textures != m_atlasTextures)
+        return nullptr;
+
+    rects = m_atlasRects;
+
+    return m_atlas;
+}
+
+// -------------------------------------------------------
+
+void MapTextureCache::setAtlas(
+        const QList<QPair<QPair<int, int>, MapTexture*>>& textures,
+        MapTexture* texture, const QHash<QPair<int, int>, QRectF>& rects)
+{
+    deleteAtlas();
+    m_atlasTextures = textures;
+    m_atlas = texture;
+    m_atlasRects = rects;
+}
+
+// -------------------------------------------------------
+
+void MapTextureCache::clear() {
+    for (QHash<MapTexture*, int>::iterator i = m_references.begin();
+         i != m_references.end(); i++)
+    {
+        delete i.key();
+    }
+    m_entries.clear();
+    m_references.clear();
+    m_outdated.clear();
+    deleteAtlas();
+}
+
+// -------------------------------------------------------
+
+void MapTextureCache::deleteTexture(MapTexture* texture) {
+
+    // Another texture could be allocated at the same address
+    for (int i = 0; i < m_atlasTextures.size(); i++) {
+        if (m_atlasTextures.at(i).second == texture) {
+            deleteAtlas();
+            break;
+        }
+    }
+    m_references.remove(texture);
+    m_outdated.remove(texture);
+    delete texture;
+}
+
+// -------------------------------------------------------
+
+void MapTextureCache::deleteAtlas() {
+    if (m_atlas != nullptr)
+        delete m_atlas;
+    m_atlas = nullptr;
+    m_atlasTextures.clear();
+    m_atlasRects.clear();
+}
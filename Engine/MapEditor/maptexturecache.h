@@ -0,0 +1,89 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPTEXTURECACHE_H
+#define MAPTEXTURECACHE_H
+
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+#include <QRectF>
+#include "maptexture.h"
+#include "picturekind.h"
+
+// -------------------------------------------------------
+//
+//  CLASS MapTextureCacheEntry
+//
+//  The current version of a picture in the cache, with the file it
+//  was decoded from.
+//
+// -------------------------------------------------------
+
+struct MapTextureCacheEntry
+{
+    MapTexture* texture;
+    QString path;
+    QDateTime lastModified;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS MapTextureCache
+//
+//  The textures shared by all the maps opened in the map editor. A
+//  picture is identified by its kind, its ID and the modification
+//  date of its file: switching to a map using the same pictures
+//  doesn't decode or upload anything. Textures are reference counted
+//  by the maps, and unused ones are kept for the next map. The last
+//  atlas built is kept too, with the pictures it packs, so that a map
+//  packing the same pictures doesn't build it again. The cache belongs
+//  to the GL context of the editor and must be cleared while this
+//  context is current.
+//
+// -------------------------------------------------------
+
+class MapTextureCache
+{
+public:
+    MapTextureCache();
+    virtual ~MapTextureCache();
+    int count() const;
+    MapTexture* acquire(PictureKind kind, int id, QString path);
+    void release(MapTexture* texture);
+    MapTexture* atlas(const QList<QPair<QPair<int, int>, MapTexture*>>&
+                      textures, QHash<QPair<int, int>, QRectF>& rects) const;
+    void setAtlas(const QList<QPair<QPair<int, int>, MapTexture*>>& textures,
+                  MapTexture* texture,
+                  const QHash<QPair<int, int>, QRectF>& rects);
+    void clear();
+
+protected:
+    QHash<QPair<int, int>, MapTextureCacheEntry> m_entries;
+    QHash<MapTexture*, int> m_references;
+    QSet<MapTexture*> m_outdated;
+    QList<QPair<QPair<int, int>, MapTexture*>> m_atlasTextures;
+    MapTexture* m_atlas;
+    QHash<QPair<int, int>, QRectF> m_atlasRects;
+
+    void deleteTexture(MapTexture* texture);
+    void deleteAtlas();
+};
+
+#endif // MAPTEXTURECACHE_H
@@ -77,3 +77,19 @@ void Position::write(QJsonArray &json) const{
     json.append(m_layer);
 }
 
+// -------------------------------------------------------
+
+void Position::readBinary(QDataStream& stream){
+    quint8 layer;
+
+    Position3D::readBinary(stream);
+    stream >> layer;
+    m_layer = layer;
+}
+
+// -------------------------------------------------------
+
+void Position::writeBinary(QDataStream& stream) const{
+    Position3D::writeBinary(stream);
+    stream << (quint8) m_layer;
+}
@@ -20,6 +20,7 @@
 #ifndef POSITION3D_H
 #define POSITION3D_H
 
+#include <QDataStream>
 #include "portion.h"
 
 // -------------------------------------------------------
@@ -46,6 +47,8 @@ public:
 
     void read(const QJsonArray &json);
     void write(QJsonArray & json) const;
+    void readBinary(QDataStream& stream);
+    void writeBinary(QDataStream& stream) const;
 
 protected:
     int m_y_plus;
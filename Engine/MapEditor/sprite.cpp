@@ -37,13 +37,6 @@ QVector3D Sprite::verticesQuad[4]{
                                   QVector3D(0.0f, 0.0f, 0.0f)
                                 };
 
-QVector2D Sprite::modelQuad[4]{
-    QVector2D(-0.5f, 0.5f),
-    QVector2D(0.5f, 0.5f),
-    QVector2D(0.5f, -0.5f),
-    QVector2D(-0.5f, -0.5f)
-};
-
 GLuint Sprite::indexesQuad[6]{0, 1, 2, 0, 2, 3};
 
 int Sprite::nbVerticesQuad(4);
@@ -82,13 +75,14 @@ Sprite::~Sprite()
 
 SpriteDatas::SpriteDatas() :
     SpriteDatas(MapEditorSubSelectionKind::SpritesFace, 50, 0,
-                new QRect(0, 0, 2, 2))
+                QRect(0, 0, 2, 2))
 {
 
 }
 
 SpriteDatas::SpriteDatas(MapEditorSubSelectionKind kind,
-                         int widthPosition, int angle, QRect *textureRect) :
+                         int widthPosition, int angle,
+                         const QRect& textureRect) :
     m_kind(kind),
     m_widthPosition(widthPosition),
     m_angle(angle),
@@ -99,7 +93,7 @@ SpriteDatas::SpriteDatas(MapEditorSubSelectionKind kind,
 
 SpriteDatas::~SpriteDatas()
 {
-    delete m_textureRect;
+
 }
 
 MapEditorSelectionKind SpriteDatas::getKind() const {
@@ -112,7 +106,7 @@ int SpriteDatas::widthPosition() const { return m_widthPosition; }
 
 int SpriteDatas::angle() const { return m_angle; }
 
-QRect* SpriteDatas::textureRect() const { return m_textureRect; }
+const QRect& SpriteDatas::textureRect() const { return m_textureRect; }
 
 // -------------------------------------------------------
 //
@@ -126,14 +120,14 @@ void SpriteDatas::getPosSizeCenter(QVector3D& pos, QVector3D& size,
 {
     // Position
     pos.setX((float) position.x() * squareSize -
-             ((textureRect()->width() - 1) * squareSize / 2) + spritesOffset);
+             ((textureRect().width() - 1) * squareSize / 2) + spritesOffset);
     pos.setY((float) position.getY(squareSize));
     pos.setZ((float) position.z() * squareSize +
              (widthPosition() * squareSize / 100) + spritesOffset);
 
     // Size
-    size.setX((float) textureRect()->width() * squareSize);
-    size.setY((float) textureRect()->height() * squareSize);
+    size.setX((float) textureRect().width() * squareSize);
+    size.setY((float) textureRect().height() * squareSize);
     size.setZ(1.0f);
 
     // Center
@@ -148,18 +142,16 @@ void SpriteDatas::initializeVertices(int squareSize,
                                      QVector<Vertex>& verticesStatic,
                                      QVector<GLuint>& indexesStatic,
                                      QVector<VertexBillboard>& verticesFace,
-                                     QVector<GLuint>& indexesFace,
                                      Position3D& position, int& countStatic,
-                                     int& countFace, int &spritesOffset)
+                                     int &spritesOffset)
 {
     QVector3D pos, size, center;
 
     float x, y, w, h;
-    int offset;
-    x = (float)(m_textureRect->x() * squareSize) / width;
-    y = (float)(m_textureRect->y() * squareSize) / height;
-    w = (float)(m_textureRect->width() * squareSize) / width;
-    h = (float)(m_textureRect->height() * squareSize) / height;
+    x = (float)(m_textureRect.x() * squareSize) / width;
+    y = (float)(m_textureRect.y() * squareSize) / height;
+    w = (float)(m_textureRect.width() * squareSize) / width;
+    h = (float)(m_textureRect.height() * squareSize) / height;
     float coefX = 0.1 / width;
     float coefY = 0.1 / height;
     x += coefX;
@@ -223,21 +215,8 @@ void SpriteDatas::initializeVertices(int squareSize,
     {
         QVector2D s(size.x(), size.y());
 
-        // Vertices
-        verticesFace.append(
-              VertexBillboard(center, texA, s, Sprite::modelQuad[0]));
-        verticesFace.append(
-              VertexBillboard(center, texB, s, Sprite::modelQuad[1]));
-        verticesFace.append(
-              VertexBillboard(center, texC, s, Sprite::modelQuad[2]));
-        verticesFace.append(
-              VertexBillboard(center, texD, s, Sprite::modelQuad[3]));
-
-        // indexes
-        offset = countFace * Sprite::nbVerticesQuad;
-        for (int i = 0; i < Sprite::nbIndexesQuad; i++)
-            indexesFace.append(Sprite::indexesQuad[i] + offset);
-        countFace++;
+        // One instance, the shader builds the quad
+        verticesFace.append(VertexBillboard(center, QVector4D(x, y, w, h), s));
         break;
     }
     default:
@@ -369,10 +348,10 @@ void SpriteDatas::read(const QJsonObject & json){
     m_angle = json["a"].toInt();
 
     QJsonArray tab = json["t"].toArray();
-    m_textureRect->setLeft(tab[0].toInt());
-    m_textureRect->setTop(tab[1].toInt());
-    m_textureRect->setWidth(tab[2].toInt());
-    m_textureRect->setHeight(tab[3].toInt());
+    m_textureRect.setLeft(tab[0].toInt());
+    m_textureRect.setTop(tab[1].toInt());
+    m_textureRect.setWidth(tab[2].toInt());
+    m_textureRect.setHeight(tab[3].toInt());
 }
 
 // -------------------------------------------------------
@@ -385,106 +364,34 @@ void SpriteDatas::write(QJsonObject & json) const{
     json["a"] = m_angle;
 
     // Texture
-    tab.append(m_textureRect->left());
-    tab.append(m_textureRect->top());
-    tab.append(m_textureRect->width());
-    tab.append(m_textureRect->height());
+    tab.append(m_textureRect.left());
+    tab.append(m_textureRect.top());
+    tab.append(m_textureRect.width());
+    tab.append(m_textureRect.height());
     json["t"] = tab;
 }
 
 // -------------------------------------------------------
-//
-//
-//  ---------- SPRITEOBJECT
-//
-//
-// -------------------------------------------------------
-
-// -------------------------------------------------------
-//
-//  CONSTRUCTOR / DESTRUCTOR / GET / SET
-//
-// -------------------------------------------------------
-
-SpriteObject::SpriteObject(SpriteDatas &datas, QOpenGLTexture* texture) :
-    m_datas(datas),
-    m_texture(texture),
-    m_vertexBuffer(QOpenGLBuffer::VertexBuffer),
-    m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-    m_programStatic(nullptr),
-    m_programFace(nullptr)
-{
-
-}
 
-SpriteObject::~SpriteObject()
+void SpriteDatas::readBinary(QDataStream& stream, const BinaryPalette& palette)
 {
+    quint8 kind;
+    qint32 widthPosition, angle;
+    quint32 textureIndex;
 
+    stream >> kind >> widthPosition >> angle >> textureIndex;
+    m_kind = static_cast<MapEditorSubSelectionKind>(kind);
+    m_widthPosition = widthPosition;
+    m_angle = angle;
+    m_textureRect = palette.rect(textureIndex);
 }
 
-// -------------------------------------------------------
-//
-//  INTERMEDIARY FUNCTIONS
-//
 // -------------------------------------------------------
 
-void SpriteObject::initializeVertices(int squareSize, Position3D& position,
-                                      int& spritesOffset)
+void SpriteDatas::writeBinary(QDataStream& stream, BinaryPalette& palette) const
 {
-    m_verticesStatic.clear();
-    m_verticesFace.clear();
-    m_indexes.clear();
-    int count = 0;
-    m_datas.initializeVertices(squareSize,
-                               m_texture->width(),
-                               m_texture->height(),
-                               m_verticesStatic, m_indexes, m_verticesFace,
-                               m_indexes, position, count, count,
-                               spritesOffset);
-}
-
-// -------------------------------------------------------
-//
-//  GL
-//
-// -------------------------------------------------------
-
-void SpriteObject::initializeStaticGL(QOpenGLShaderProgram* programStatic){
-    if (m_programStatic == nullptr){
-        initializeOpenGLFunctions();
-        m_programStatic = programStatic;
-    }
-}
-
-// -------------------------------------------------------
-
-void SpriteObject::initializeFaceGL(QOpenGLShaderProgram *programFace){
-    if (m_programFace == nullptr){
-        initializeOpenGLFunctions();
-        m_programFace = programFace;
-    }
-}
-
-// -------------------------------------------------------
-
-void SpriteObject::updateStaticGL(){
-    Map::updateGLStatic(m_vertexBuffer, m_indexBuffer, m_verticesStatic,
-                        m_indexes, m_vao, m_programStatic);
-}
-
-// -------------------------------------------------------
-
-void SpriteObject::updateFaceGL(){
-    Map::updateGLFace(m_vertexBuffer, m_indexBuffer, m_verticesFace,
-                      m_indexes, m_vao, m_programFace);
-}
-
-// -------------------------------------------------------
-
-void SpriteObject::paintGL(){
-    m_vao.bind();
-    glDrawElements(GL_TRIANGLES, m_indexes.size(), GL_UNSIGNED_INT, 0);
-    m_vao.bind();
+    stream << (quint8) m_kind << (qint32) m_widthPosition << (qint32) m_angle
+           << palette.rectIndex(m_textureRect);
 }
 
 // -------------------------------------------------------
@@ -715,3 +622,20 @@ void SpriteWallDatas::write(QJsonObject & json) const{
     json["w"] = m_wallID;
     json["k"] = (int) m_wallKind;
 }
+
+// -------------------------------------------------------
+
+void SpriteWallDatas::readBinary(QDataStream& stream, const BinaryPalette&){
+    qint32 wallID;
+    quint8 wallKind;
+
+    stream >> wallID >> wallKind;
+    m_wallID = wallID;
+    m_wallKind = static_cast<SpriteWallKind>(wallKind);
+}
+
+// -------------------------------------------------------
+
+void SpriteWallDatas::writeBinary(QDataStream& stream, BinaryPalette&) const{
+    stream << (qint32) m_wallID << (quint8) m_wallKind;
+}
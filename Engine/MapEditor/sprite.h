@@ -24,7 +24,6 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
-#include <QOpenGLTexture>
 #include <QHash>
 #include <QVector>
 #include "serializable.h"
@@ -37,6 +36,7 @@
 #include "gridposition.h"
 #include "spritewallkind.h"
 #include "qray3d.h"
+#include "maptexture.h"
 
 // -------------------------------------------------------
 //
@@ -52,7 +52,6 @@ public:
     Sprite();
     virtual ~Sprite();
     static QVector3D verticesQuad[];
-    static QVector2D modelQuad[];
     static GLuint indexesQuad[];
     static int nbVerticesQuad;
     static int nbIndexesQuad;
@@ -72,13 +71,13 @@ class SpriteDatas : public MapElement
 public:
     SpriteDatas();
     SpriteDatas(MapEditorSubSelectionKind kind, int widthPosition,
-                int angle, QRect* textureRect);
+                int angle, const QRect& textureRect);
     virtual ~SpriteDatas();
     virtual MapEditorSelectionKind getKind() const;
     virtual MapEditorSubSelectionKind getSubKind() const;
     int widthPosition() const;
     int angle() const;
-    QRect* textureRect() const;
+    const QRect& textureRect() const;
     void getPosSizeCenter(QVector3D& pos, QVector3D& size, QVector3D& center,
                           int squareSize, Position3D &position,
                           int& spritesOffset);
@@ -86,9 +85,8 @@ public:
                                     QVector<Vertex>& verticesStatic,
                                     QVector<GLuint>& indexesStatic,
                                     QVector<VertexBillboard>& verticesFace,
-                                    QVector<GLuint>& indexesFace,
                                     Position3D& position, int& countStatic,
-                                    int& countFace, int& spritesOffset);
+                                    int& spritesOffset);
     static void rotateVertex(QVector3D& vec, QVector3D& center, int angle);
     static void rotateSprite(QVector3D& vecA, QVector3D& vecB, QVector3D& vecC,
                              QVector3D& vecD, QVector3D& center, int angle);
@@ -104,48 +102,14 @@ public:
 
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject &json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 protected:
     MapEditorSubSelectionKind m_kind;
     int m_widthPosition;
     int m_angle;
-    QRect* m_textureRect;
-};
-
-// -------------------------------------------------------
-//
-//  CLASS SpriteObject
-//
-//  A sprite object in a portion of the map.
-//
-// -------------------------------------------------------
-
-class SpriteObject : protected QOpenGLFunctions
-{
-public:
-    SpriteObject(SpriteDatas& datas, QOpenGLTexture* texture);
-    virtual ~SpriteObject();
-    void initializeVertices(int squareSize, Position3D& position,
-                            int &spritesOffset);
-    void initializeStaticGL(QOpenGLShaderProgram* programStatic);
-    void initializeFaceGL(QOpenGLShaderProgram *programFace);
-    void updateStaticGL();
-    void updateFaceGL();
-    void paintGL();
-
-protected:
-    SpriteDatas& m_datas;
-    QOpenGLTexture* m_texture;
-
-    // OpenGL static
-    QOpenGLBuffer m_vertexBuffer;
-    QOpenGLBuffer m_indexBuffer;
-    QVector<Vertex> m_verticesStatic;
-    QVector<GLuint> m_indexes;
-    QOpenGLVertexArrayObject m_vao;
-    QOpenGLShaderProgram* m_programStatic;
-    QVector<VertexBillboard> m_verticesFace;
-    QOpenGLShaderProgram* m_programFace;
+    QRect m_textureRect;
 };
 
 // -------------------------------------------------------
@@ -180,6 +144,8 @@ public:
                                     GridPosition& position, int& count);
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject &json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 protected:
     int m_wallID;
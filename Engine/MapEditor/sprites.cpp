@@ -17,78 +17,11 @@
     along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <QMap>
 #include "sprites.h"
 #include "map.h"
 #include "wanok.h"
 
-// -------------------------------------------------------
-//
-//
-//  ---------- SPRITESWALLS
-//
-//
-// -------------------------------------------------------
-
-// -------------------------------------------------------
-//
-//  CONSTRUCTOR / DESTRUCTOR / GET / SET
-//
-// -------------------------------------------------------
-
-SpritesWalls::SpritesWalls() :
-    m_count(0),
-    m_vertexBuffer(QOpenGLBuffer::VertexBuffer),
-    m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-    m_program(nullptr)
-{
-
-}
-
-SpritesWalls::~SpritesWalls()
-{
-
-}
-
-// -------------------------------------------------------
-//
-//  GL
-//
-// -------------------------------------------------------
-
-void SpritesWalls::initializeVertices(GridPosition& position,
-                                      SpriteWallDatas* sprite,
-                                      int squareSize, int width, int height)
-{
-    sprite->initializeVertices(squareSize, width, height, m_vertices,
-                                   m_indexes, position, m_count);
-}
-
-// -------------------------------------------------------
-
-void SpritesWalls::initializeGL(QOpenGLShaderProgram* program) {
-    if (m_program == nullptr){
-        initializeOpenGLFunctions();
-
-        // Programs
-        m_program = program;
-    }
-}
-
-// -------------------------------------------------------
-
-void SpritesWalls::updateGL(){
-    Map::updateGLStatic(m_vertexBuffer, m_indexBuffer, m_vertices, m_indexes,
-                        m_vao, m_program);
-}
-
-// -------------------------------------------------------
-
-void SpritesWalls::paintGL(){
-    m_vao.bind();
-    glDrawElements(GL_TRIANGLES, m_indexes.size(), GL_UNSIGNED_INT, 0);
-    m_vao.release();
-}
-
 // -------------------------------------------------------
 //
 //
@@ -103,30 +36,19 @@ void SpritesWalls::paintGL(){
 //
 // -------------------------------------------------------
 
-Sprites::Sprites() :
-    m_vertexBufferStatic(QOpenGLBuffer::VertexBuffer),
-    m_indexBufferStatic(QOpenGLBuffer::IndexBuffer),
-    m_programStatic(nullptr),
-    m_vertexBufferFace(QOpenGLBuffer::VertexBuffer),
-    m_indexBufferFace(QOpenGLBuffer::IndexBuffer),
-    m_programFace(nullptr)
+Sprites::Sprites()
 {
 
 }
 
 Sprites::~Sprites()
 {
-    QHash<Position, SpriteDatas*>::iterator i;
-    for (i = m_all.begin(); i != m_all.end(); i++)
-        delete *i;
 
-    QHash<GridPosition, SpriteWallDatas*>::iterator j;
-    for (j = m_walls.begin(); j != m_walls.end(); j++)
-        delete *j;
+}
 
-    QHash<int, SpritesWalls*>::iterator k;
-    for (k = m_wallsGL.begin(); k != m_wallsGL.end(); k++)
-        delete *k;
+qint64 Sprites::memorySize() const {
+    return m_spritesPool.count() * sizeof(SpriteDatas) +
+            m_wallsPool.count() * sizeof(SpriteWallDatas);
 }
 
 void Sprites::addOverflow(Position& p) {
@@ -149,6 +71,14 @@ bool Sprites::isEmpty() const{
 
 // -------------------------------------------------------
 
+void Sprites::getWallsUsed(QSet<int>& walls) const {
+    QHash<GridPosition, SpriteWallDatas*>::const_iterator i;
+    for (i = m_walls.begin(); i != m_walls.end(); i++)
+        walls.insert(i.value()->wallID());
+}
+
+// -------------------------------------------------------
+
 bool Sprites::contains(Position& position) const {
     return m_all.contains(position);
 }
@@ -178,8 +108,8 @@ void Sprites::getSetPortionsOverflow(QSet<Portion>& portionsOverflow,
                                      Position& p, SpriteDatas* sprite)
 {
     Portion currentPortion = Map::getGlobalPortion(p);
-    int r = sprite->textureRect()->width() / 2;
-    int h = sprite->textureRect()->height();
+    int r = sprite->textureRect().width() / 2;
+    int h = sprite->textureRect().height();
 
     for (int i = -r; i < r; i++) {
         for (int j = 0; j < h; j++) {
@@ -256,15 +186,14 @@ SpriteDatas* Sprites::removeSprite(QSet<Portion>& portionsOverflow, Position& p)
 
 bool Sprites::addSprite(QSet<Portion>& portionsOverflow, Position& p,
                         MapEditorSubSelectionKind kind, int widthPosition,
-                        int angle, QRect *textureRect)
+                        int angle, const QRect& textureRect)
 {
     QSet<Portion> portionsOverflowRemove, portionsOverflowSet;
     SpriteDatas* previousSprite = removeSprite(portionsOverflowRemove, p);
-    SpriteDatas* sprite = new SpriteDatas(kind, widthPosition, angle,
-                                          textureRect);
-
     if (previousSprite != nullptr)
-        delete previousSprite;
+        m_spritesPool.destroy(previousSprite);
+    SpriteDatas* sprite = m_spritesPool.create(kind, widthPosition, angle,
+                                               textureRect);
 
     setSprite(portionsOverflowSet, p, sprite);
 
@@ -281,7 +210,7 @@ bool Sprites::deleteSprite(QSet<Portion>& portionsOverflow, Position& p){
     SpriteDatas* previousSprite = removeSprite(portionsOverflow, p);
 
     if (previousSprite != nullptr)
-        delete previousSprite;
+        m_spritesPool.destroy(previousSprite);
 
     return true;
 }
@@ -308,10 +237,9 @@ SpriteWallDatas* Sprites::removeSpriteWall(GridPosition &p) {
 
 bool Sprites::addSpriteWall(GridPosition& p, int specialID) {
     SpriteWallDatas* previousSprite = removeSpriteWall(p);
-    SpriteWallDatas* sprite = new SpriteWallDatas(specialID);
-
     if (previousSprite != nullptr)
-        delete previousSprite;
+        m_wallsPool.destroy(previousSprite);
+    SpriteWallDatas* sprite = m_wallsPool.create(specialID);
 
     setSpriteWall(p, sprite);
 
@@ -324,7 +252,7 @@ bool Sprites::deleteSpriteWall(GridPosition& p) {
     SpriteWallDatas* previousSprite = removeSpriteWall(p);
 
     if (previousSprite != nullptr)
-        delete previousSprite;
+        m_wallsPool.destroy(previousSprite);
 
     return true;
 }
@@ -394,7 +322,7 @@ void Sprites::removeSpritesOut(MapProperties& properties) {
         if (position.x() >= properties.length() ||
             position.z() >= properties.width())
         {
-            delete i.value();
+            m_spritesPool.destroy(i.value());
             listGlobal.push_back(position);
         }
     }
@@ -409,7 +337,7 @@ void Sprites::removeSpritesOut(MapProperties& properties) {
         if (gridPosition.x1() >= properties.length() ||
             gridPosition.z1() >= properties.width())
         {
-            delete j.value();
+            m_wallsPool.destroy(j.value());
             listWalls.push_back(gridPosition);
         }
     }
@@ -439,6 +367,8 @@ void Sprites::updateRaycasting(int squareSize, float &finalDistance,
         Position position = *i;
         Portion portion = map->getLocalPortion(position);
         MapPortion* mapPortion = map->mapPortion(portion);
+        if (mapPortion == nullptr)
+            continue;
         mapPortion->updateRaycastingOverflowSprite(squareSize, position,
                                                    finalDistance, finalPosition,
                                                    ray, cameraHAngle);
@@ -464,27 +394,18 @@ void Sprites::updateRaycastingAt(Position &position, SpriteDatas *sprite,
 //
 // -------------------------------------------------------
 
-void Sprites::initializeVertices(QHash<int, QOpenGLTexture *> &texturesWalls,
+void Sprites::initializeVertices(MapPortionChunks& chunks,
+                                 MapTextureAtlas& atlas,
+                                 QHash<int, MapTexture*>& texturesWalls,
                                  QHash<Position, MapElement *> &previewSquares,
                                  QHash<GridPosition, MapElement *> &previewGrid,
                                  QList<GridPosition> &previewDeleteGrid,
                                  int squareSize, int width, int height,
                                  int& spritesOffset)
 {
-    int countStatic = 0;
-    int countFace = 0;
-
-    // Clear
-    m_verticesStatic.clear();
-    m_indexesStatic.clear();
-    m_verticesFace.clear();
-    m_indexesFace.clear();
-    for (QHash<int, SpritesWalls*>::iterator i = m_wallsGL.begin();
-         i != m_wallsGL.end(); i++)
-    {
-        delete *i;
-    }
-    m_wallsGL.clear();
+    int count = MapPortionChunks::count();
+    QVector<MapPortionGeometry> sprites(count);
+    QVector<QMap<int, MapPortionGeometry>> walls(count);
 
     // Create temp hash for preview
     QHash<Position, SpriteDatas*> spritesWithPreview(m_all);
@@ -498,94 +419,64 @@ void Sprites::initializeVertices(QHash<int, QOpenGLTexture *> &texturesWalls,
     QHash<GridPosition, SpriteWallDatas*> spritesWallWithPreview;
     getWallsWithPreview(spritesWallWithPreview, previewGrid, previewDeleteGrid);
 
-    // Initialize vertices in squares
+    // Initialize vertices in squares of the dirty chunks
     for (QHash<Position, SpriteDatas*>::iterator i = spritesWithPreview.begin();
          i != spritesWithPreview.end(); i++)
     {
         Position position = i.key();
+        int chunk = chunks.index(position.x(), position.z());
+        if (!chunks.isDirty(chunk))
+            continue;
         SpriteDatas* sprite = i.value();
+        MapPortionGeometry& geometry = sprites[chunk];
 
         sprite->initializeVertices(squareSize, width, height,
-                                   m_verticesStatic, m_indexesStatic,
-                                   m_verticesFace, m_indexesFace,
-                                   position, countStatic, countFace,
-                                   spritesOffset);
+                                   geometry.verticesStatic,
+                                   geometry.indexesStatic,
+                                   geometry.verticesFace, position,
+                                   geometry.countStatic, spritesOffset);
     }
 
-    // Initialize vertices for walls
+    // Initialize vertices for walls, grouped by texture
     for (QHash<GridPosition, SpriteWallDatas*>::iterator i =
          spritesWallWithPreview.begin(); i != spritesWallWithPreview.end(); i++)
     {
         GridPosition gridPosition = i.key();
+        int chunk = chunks.index(gridPosition.x1(), gridPosition.z1());
+        if (!chunks.isDirty(chunk))
+            continue;
         SpriteWallDatas* sprite = i.value();
         int id = sprite->wallID();
-        SpritesWalls* sprites = m_wallsGL.value(id);
-        if (sprites == nullptr) {
-            sprites = new SpritesWalls;
-            m_wallsGL[id] = sprites;
-        }
-        QOpenGLTexture* texture = texturesWalls.value(id);
+        MapPortionGeometry& geometry = walls[chunk][id];
+        MapTexture* texture = texturesWalls.value(id);
         if (texture == nullptr)
             texture = texturesWalls.value(-1);
 
-        sprites->initializeVertices(gridPosition, sprite, squareSize,
-                                    texture->width(), texture->height());
+        sprite->initializeVertices(squareSize, texture->width(),
+                                   texture->height(), geometry.verticesStatic,
+                                   geometry.indexesStatic, gridPosition,
+                                   geometry.countStatic);
     }
-}
-
-// -------------------------------------------------------
-
-void Sprites::initializeGL(QOpenGLShaderProgram* programStatic,
-                           QOpenGLShaderProgram *programFace){
-    if (m_programStatic == nullptr){
-        initializeOpenGLFunctions();
-
-        // Programs
-        m_programStatic = programStatic;
-        m_programFace = programFace;
+    for (int j = 0; j < count; j++) {
+        if (!chunks.isDirty(j))
+            continue;
+        chunks.add(j, MapPortionRangeKind::Sprites, -1,
+                   MapPortionRangeKind::Sprites, -1, sprites[j]);
+        for (QMap<int, MapPortionGeometry>::iterator i = walls[j].begin();
+             i != walls[j].end(); i++)
+        {
+            if (atlas.contains(PictureKind::Walls, i.key())) {
+                i.value().mapTexCoords(atlas.rect(PictureKind::Walls,
+                                                  i.key()));
+                chunks.add(j, MapPortionRangeKind::Walls, i.key(),
+                           MapPortionRangeKind::Atlas, -1, i.value());
+            }
+            else {
+                chunks.add(j, MapPortionRangeKind::Walls, i.key(),
+                           MapPortionRangeKind::Walls, i.key(), i.value());
+            }
+        }
     }
-
-    QHash<int, SpritesWalls*>::iterator i;
-    for (i = m_wallsGL.begin(); i != m_wallsGL.end(); i++)
-        i.value()->initializeGL(programStatic);
-}
-
-// -------------------------------------------------------
-
-void Sprites::updateGL(){
-    Map::updateGLStatic(m_vertexBufferStatic, m_indexBufferStatic,
-                        m_verticesStatic, m_indexesStatic, m_vaoStatic,
-                        m_programStatic);
-    Map::updateGLFace(m_vertexBufferFace, m_indexBufferFace,
-                      m_verticesFace, m_indexesFace, m_vaoFace,
-                      m_programFace);
-    QHash<int, SpritesWalls*>::iterator i;
-    for (i = m_wallsGL.begin(); i != m_wallsGL.end(); i++)
-        i.value()->updateGL();
-}
-
-// -------------------------------------------------------
-
-void Sprites::paintGL(){
-    m_vaoStatic.bind();
-    glDrawElements(GL_TRIANGLES, m_indexesStatic.size(), GL_UNSIGNED_INT, 0);
-    m_vaoStatic.release();
-}
-
-// -------------------------------------------------------
-
-void Sprites::paintFaceGL(){
-    m_vaoFace.bind();
-    glDrawElements(GL_TRIANGLES, m_indexesFace.size(), GL_UNSIGNED_INT, 0);
-    m_vaoFace.release();
-}
-
-// -------------------------------------------------------
-
-void Sprites::paintSpritesWalls(int textureID) {
-    SpritesWalls* sprites = m_wallsGL.value(textureID);
-    if (sprites != nullptr)
-        sprites->paintGL();
 }
 
 // -------------------------------------------------------
@@ -598,24 +489,26 @@ void Sprites::read(const QJsonObject & json){
     QJsonArray tab = json["list"].toArray();
 
     // Globals
+    m_spritesPool.reserve(tab.size());
     for (int i = 0; i < tab.size(); i++){
         QJsonObject obj = tab.at(i).toObject();
         Position p;
         p.read(obj["k"].toArray());
         QJsonObject objVal = obj["v"].toObject();
-        SpriteDatas* sprite = new SpriteDatas;
+        SpriteDatas* sprite = m_spritesPool.create();
         sprite->read(objVal);
         m_all[p] = sprite;
     }
 
     // Walls
     tab = json["walls"].toArray();
+    m_wallsPool.reserve(tab.size());
     for (int i = 0; i < tab.size(); i++){
         QJsonObject obj = tab.at(i).toObject();
         GridPosition p;
         p.read(obj["k"].toArray());
         QJsonObject objVal = obj["v"].toObject();
-        SpriteWallDatas* sprite = new SpriteWallDatas;
+        SpriteWallDatas* sprite = m_wallsPool.create();
         sprite->read(objVal);
         m_walls[p] = sprite;
     }
@@ -678,3 +571,70 @@ void Sprites::write(QJsonObject & json) const{
     }
     json["overflow"] = tabOverflow;
 }
+
+// -------------------------------------------------------
+
+void Sprites::readBinary(QDataStream& stream, const BinaryPalette& palette){
+    quint32 count;
+
+    // Globals
+    stream >> count;
+    m_spritesPool.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+        Position p;
+        p.readBinary(stream);
+        SpriteDatas* sprite = m_spritesPool.create();
+        sprite->readBinary(stream, palette);
+        m_all[p] = sprite;
+    }
+
+    // Walls
+    stream >> count;
+    m_wallsPool.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+        GridPosition p;
+        p.readBinary(stream);
+        SpriteWallDatas* sprite = m_wallsPool.create();
+        sprite->readBinary(stream, palette);
+        m_walls[p] = sprite;
+    }
+
+    // Overflow
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+        Position position;
+        position.readBinary(stream);
+        m_overflow += position;
+    }
+}
+
+// -------------------------------------------------------
+
+void Sprites::writeBinary(QDataStream& stream, BinaryPalette& palette) const{
+
+    // Globals
+    stream << (quint32) m_all.size();
+    for (QHash<Position, SpriteDatas*>::const_iterator i = m_all.begin();
+         i != m_all.end(); i++)
+    {
+        i.key().writeBinary(stream);
+        i.value()->writeBinary(stream, palette);
+    }
+
+    // Walls
+    stream << (quint32) m_walls.size();
+    for (QHash<GridPosition, SpriteWallDatas*>::const_iterator i =
+         m_walls.begin(); i != m_walls.end(); i++)
+    {
+        i.key().writeBinary(stream);
+        i.value()->writeBinary(stream, palette);
+    }
+
+    // Overflow
+    stream << (quint32) m_overflow.size();
+    for (QSet<Position>::const_iterator i = m_overflow.begin();
+         i != m_overflow.end(); i++)
+    {
+        (*i).writeBinary(stream);
+    }
+}
@@ -21,54 +21,29 @@
 #define SPRITES_H
 
 #include "sprite.h"
-
-// -------------------------------------------------------
-//
-//  CLASS SpritesWalls
-//
-//  A set of sprites walls in a portion of the map.
-//
-// -------------------------------------------------------
-
-class SpritesWalls : protected QOpenGLFunctions
-{
-public:
-    SpritesWalls();
-    virtual ~SpritesWalls();
-    void initializeVertices(GridPosition& position, SpriteWallDatas* sprite,
-                            int squareSize, int width, int height);
-    void initializeGL(QOpenGLShaderProgram* program);
-    void updateGL();
-    void paintGL();
-
-protected:
-    int m_count;
-
-    // OpenGL
-    QOpenGLBuffer m_vertexBuffer;
-    QOpenGLBuffer m_indexBuffer;
-    QVector<Vertex> m_vertices;
-    QVector<GLuint> m_indexes;
-    QOpenGLVertexArrayObject m_vao;
-    QOpenGLShaderProgram* m_program;
-};
+#include "mapelementpool.h"
+#include "mapportionchunks.h"
+#include "maptextureatlas.h"
 
 // -------------------------------------------------------
 //
 //  CLASS Sprites
 //
-//  A set of sprites in a portion of the map.
+//  A set of sprites in a portion of the map. The sprites are stored in
+//  pools, so they are all released at once with the portion.
 //
 // -------------------------------------------------------
 
-class Sprites : public Serializable, protected QOpenGLFunctions
+class Sprites : public Serializable, public BinarySerializable
 {
 public:
     Sprites();
     virtual ~Sprites();
+    qint64 memorySize() const;
     void addOverflow(Position& p);
     void removeOverflow(Position& p);
     bool isEmpty() const;
+    void getWallsUsed(QSet<int>& walls) const;
     bool contains(Position& position) const;
     SpriteDatas* spriteAt(Position& position) const;
     void setSprite(QSet<Portion>& portionsOverflow, Position& p,
@@ -80,7 +55,7 @@ public:
     SpriteDatas* removeSprite(QSet<Portion> &portionsOverflow, Position& p);
     bool addSprite(QSet<Portion> &portionsOverflow, Position& p,
                    MapEditorSubSelectionKind kind, int widthPosition, int angle,
-                   QRect *textureRect);
+                   const QRect& textureRect);
     bool deleteSprite(QSet<Portion> &portionsOverflow, Position& p);
     void setSpriteWall(GridPosition& p, SpriteWallDatas* sprite);
     SpriteWallDatas* removeSpriteWall(GridPosition& p);
@@ -105,43 +80,25 @@ public:
                             Position &finalPosition, QRay3D& ray,
                             double cameraHAngle, int& spritesOffset);
 
-    void initializeVertices(QHash<int, QOpenGLTexture*>& texturesWalls,
+    void initializeVertices(MapPortionChunks& chunks, MapTextureAtlas& atlas,
+                            QHash<int, MapTexture*>& texturesWalls,
                             QHash<Position, MapElement*>& previewSquares,
                             QHash<GridPosition, MapElement*>& previewGrid,
                             QList<GridPosition>& previewDeleteGrid,
                             int squareSize, int width, int height,
                             int& spritesOffset);
-    void initializeGL(QOpenGLShaderProgram* programStatic,
-                      QOpenGLShaderProgram* programFace);
-    void updateGL();
-    void paintGL();
-    void paintFaceGL();
-    void paintSpritesWalls(int textureID);
 
     virtual void read(const QJsonObject &json);
     virtual void write(QJsonObject &json) const;
+    virtual void readBinary(QDataStream& stream, const BinaryPalette& palette);
+    virtual void writeBinary(QDataStream& stream, BinaryPalette& palette) const;
 
 protected:
+    MapElementPool<SpriteDatas> m_spritesPool;
+    MapElementPool<SpriteWallDatas> m_wallsPool;
     QHash<Position, SpriteDatas*> m_all;
     QHash<GridPosition, SpriteWallDatas*> m_walls;
-    QHash<int, SpritesWalls*> m_wallsGL;
     QSet<Position> m_overflow;
-
-    // OpenGL static
-    QOpenGLBuffer m_vertexBufferStatic;
-    QOpenGLBuffer m_indexBufferStatic;
-    QVector<Vertex> m_verticesStatic;
-    QVector<GLuint> m_indexesStatic;
-    QOpenGLVertexArrayObject m_vaoStatic;
-    QOpenGLShaderProgram* m_programStatic;
-
-    // OpenGL face
-    QOpenGLBuffer m_vertexBufferFace;
-    QOpenGLBuffer m_indexBufferFace;
-    QVector<VertexBillboard> m_verticesFace;
-    QVector<GLuint> m_indexesFace;
-    QOpenGLVertexArrayObject m_vaoFace;
-    QOpenGLShaderProgram* m_programFace;
 };
 
 #endif // SPRITES_H
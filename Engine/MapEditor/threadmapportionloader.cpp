@@ -18,6 +18,7 @@
 */
 
 #include "threadmapportionloader.h"
+#include "mapportionloader.h"
 #include "map.h"
 
 // -------------------------------------------------------
@@ -26,9 +27,10 @@
 //
 // -------------------------------------------------------
 
-ThreadMapPortionLoader::ThreadMapPortionLoader(Map *map, MapPortion *mapPortion) :
+ThreadMapPortionLoader::ThreadMapPortionLoader(Map *map,
+                                               MapPortionLoader *loader) :
     m_map(map),
-    m_mapPortion(mapPortion)
+    m_loader(loader)
 {
 
 }
@@ -40,6 +42,13 @@ ThreadMapPortionLoader::ThreadMapPortionLoader(Map *map, MapPortion *mapPortion)
 // -------------------------------------------------------
 
 void ThreadMapPortionLoader::run() {
-    m_map->loadPortionThread(m_mapPortion);
-    m_mapPortion->setIsLoaded(true);
+    Portion portion;
+    while (m_loader->takeJob(portion)) {
+        MapPortion* mapPortion = m_map->loadPortionMap(portion.x(),
+                                                       portion.y(),
+                                                       portion.z());
+        if (mapPortion != nullptr)
+            m_map->loadPortionThread(mapPortion);
+        m_loader->finishJob(mapPortion);
+    }
 }
@@ -23,13 +23,15 @@
 #include <QThread>
 
 class Map;
-class MapPortion;
+class MapPortionLoader;
 
 // -------------------------------------------------------
 //
 //  CLASS ThreadMapPortionLoader
 //
-//  A thread used for loading a portion asynchronously.
+//  A worker thread loading the portions queued in a MapPortionLoader:
+//  reading the file and building the vertices. Nothing here touches
+//  OpenGL.
 //
 // -------------------------------------------------------
 
@@ -37,18 +39,11 @@ class ThreadMapPortionLoader : public QThread
 {
     Q_OBJECT
 public:
-    ThreadMapPortionLoader(Map* map, MapPortion* mapPortion);
+    ThreadMapPortionLoader(Map* map, MapPortionLoader* loader);
 
 protected:
     Map* m_map;
-    MapPortion* m_mapPortion;
-    /*
-    int m_realX;
-    int m_realY;
-    int m_realZ;
-    int m_x;
-    int m_y;
-    int m_z;*/
+    MapPortionLoader* m_loader;
 
     void run();
 };
@@ -21,28 +21,25 @@
 
 const int VertexBillboard::positionTupleSize = 3;
 
-const int VertexBillboard::texCoupleSize = 2;
+const int VertexBillboard::texRectTupleSize = 4;
 
 const int VertexBillboard::sizeCoupleSize = 2;
 
-const int VertexBillboard::modelCoupleSize = 2;
+// Two triangles, see corners in spriteFace.vert
+const int VertexBillboard::verticesCount = 6;
 
 int VertexBillboard::positionOffset() {
     return offsetof(VertexBillboard, m_centerPosition);
 }
 
-int VertexBillboard::texOffset() {
-    return offsetof(VertexBillboard, m_tex);
+int VertexBillboard::texRectOffset() {
+    return offsetof(VertexBillboard, m_texRect);
 }
 
 int VertexBillboard::sizeOffset() {
     return offsetof(VertexBillboard, m_size);
 }
 
-int VertexBillboard::modelOffset() {
-    return offsetof(VertexBillboard, m_model);
-}
-
 int VertexBillboard::stride() {
     return sizeof(VertexBillboard);
 }
@@ -59,12 +56,11 @@ VertexBillboard::VertexBillboard()
 }
 
 VertexBillboard::VertexBillboard(const QVector3D &position,
-                                 const QVector2D &tex, const QVector2D &size,
-                                 const QVector2D &model) :
+                                 const QVector4D &texRect,
+                                 const QVector2D &size) :
     m_centerPosition(position),
-    m_tex(tex),
-    m_size(size),
-    m_model(model)
+    m_texRect(texRect),
+    m_size(size)
 {
 
 }
@@ -75,15 +71,12 @@ void VertexBillboard::setCenterPosition(const QVector3D& position) {
     m_centerPosition = position;
 }
 
-QVector2D VertexBillboard::tex() const { return m_tex; }
+QVector4D VertexBillboard::texRect() const { return m_texRect; }
 
-void VertexBillboard::setTex(const QVector2D &tex) { m_tex = tex; }
+void VertexBillboard::setTexRect(const QVector4D &texRect) {
+    m_texRect = texRect;
+}
 
 QVector2D VertexBillboard::size() const { return m_size; }
 
 void VertexBillboard::setSize(const QVector2D& size) { m_size = size; }
-
-QVector2D VertexBillboard::model() const { return m_model; }
-
-void VertexBillboard::setModel(QVector2D &model) { m_model = model; }
-
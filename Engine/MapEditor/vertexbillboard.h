@@ -20,14 +20,17 @@
 #ifndef VERTEXBILLBOARD_H
 #define VERTEXBILLBOARD_H
 
-#include <QVector3D>
 #include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
 
 // -------------------------------------------------------
 //
 //  CLASS VertexBillboard
 //
-//  A vertex used for drawing billboard sprites.
+//  A billboard sprite, drawn as one instance of a quad. The corners
+//  of the quad are computed by the shader from the center, the size
+//  and the texture rect (x, y, width, height).
 //
 // -------------------------------------------------------
 
@@ -35,31 +38,27 @@ class VertexBillboard
 {
 public:
     VertexBillboard();
-    VertexBillboard(const QVector3D &position, const QVector2D &tex,
-                    const QVector2D &size, const QVector2D &model);
+    VertexBillboard(const QVector3D &position, const QVector4D &texRect,
+                    const QVector2D &size);
     QVector3D centerPosition() const;
     void setCenterPosition(const QVector3D& position);
-    QVector2D tex() const;
-    void setTex(const QVector2D& tex);
+    QVector4D texRect() const;
+    void setTexRect(const QVector4D& texRect);
     QVector2D size() const;
     void setSize(const QVector2D& size);
-    QVector2D model() const;
-    void setModel(QVector2D& model);
     static const int positionTupleSize;
-    static const int texCoupleSize;
+    static const int texRectTupleSize;
     static const int sizeCoupleSize;
-    static const int modelCoupleSize;
+    static const int verticesCount;
     static int positionOffset();
-    static int texOffset();
+    static int texRectOffset();
     static int sizeOffset();
-    static int modelOffset();
     static int stride();
 
 protected:
     QVector3D m_centerPosition;
-    QVector2D m_tex;
+    QVector4D m_texRect;
     QVector2D m_size;
-    QVector2D m_model;
 };
 
 #endif // VERTEXBILLBOARD_H
@@ -148,19 +148,10 @@ void GameDatas::setDefault(){
 // -------------------------------------------------------
 
 void GameDatas::read(QString path){
-    readVariablesSwitches(path);
-    m_commonEventsDatas->read(path);
-    readSystem(path);
-    m_itemsDatas->read(path);
-    m_skillsDatas->read(path);
-    m_battleSystemDatas->read(path);
-    m_weaponsDatas->read(path);
-    m_armorsDatas->read(path);
-    m_heroesDatas->read(path);
-    m_monstersDatas->read(path);
-    m_troopsDatas->read(path);
-    m_classesDatas->read(path);
-    readTilesets(path);
+    QList<QPair<QString, Serializable*>> files;
+    getFiles(path, files);
+    for (int i = 0; i < files.size(); i++)
+        Wanok::readJSON(files.at(i).first, *files.at(i).second);
 }
 
 // -------------------------------------------------------
@@ -183,31 +174,41 @@ void GameDatas::readSystem(QString path){
 
 // -------------------------------------------------------
 
+void GameDatas::getFiles(QString path,
+                         QList<QPair<QString, Serializable*>>& files) const
+{
+    // In the reading order: some models need the previous ones
+    addFile(files, path, Wanok::pathVariables, m_variablesDatas);
+    addFile(files, path, Wanok::pathCommonEvents, m_commonEventsDatas);
+    addFile(files, path, Wanok::pathSystem, m_systemDatas);
+    addFile(files, path, Wanok::pathItems, m_itemsDatas);
+    addFile(files, path, Wanok::pathSkills, m_skillsDatas);
+    addFile(files, path, Wanok::pathBattleSystem, m_battleSystemDatas);
+    addFile(files, path, Wanok::pathWeapons, m_weaponsDatas);
+    addFile(files, path, Wanok::pathArmors, m_armorsDatas);
+    addFile(files, path, Wanok::pathHeroes, m_heroesDatas);
+    addFile(files, path, Wanok::pathMonsters, m_monstersDatas);
+    addFile(files, path, Wanok::pathTroops, m_troopsDatas);
+    addFile(files, path, Wanok::pathClasses, m_classesDatas);
+    addFile(files, path, Wanok::PATH_TILESETS, m_tilesetsDatas);
+}
+
+// -------------------------------------------------------
+
+void GameDatas::addFile(QList<QPair<QString, Serializable*>>& files,
+                        QString path, QString fileName, Serializable* datas)
+{
+    files.append(QPair<QString, Serializable*>(
+                     Wanok::pathCombine(path, fileName), datas));
+}
+
+// -------------------------------------------------------
+
 void GameDatas::write(QString path){
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathCommonEvents),
-                     *m_commonEventsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathVariables),
-                     *m_variablesDatas);
-    writeSystem(path);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathBattleSystem),
-                     *m_battleSystemDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathItems),
-                     *m_itemsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathSkills),
-                     *m_skillsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathWeapons),
-                     *m_weaponsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathArmors),
-                     *m_armorsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathHeroes),
-                     *m_heroesDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathMonsters),
-                     *m_monstersDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathTroops),
-                     *m_troopsDatas);
-    Wanok::writeJSON(Wanok::pathCombine(path, Wanok::pathClasses),
-                     *m_classesDatas);
-    writeTilesets(path);
+    QList<QPair<QString, Serializable*>> files;
+    getFiles(path, files);
+    for (int i = 0; i < files.size(); i++)
+        Wanok::writeJSON(files.at(i).first, *files.at(i).second);
 }
 
 // -------------------------------------------------------
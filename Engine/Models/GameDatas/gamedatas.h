@@ -66,9 +66,13 @@ public:
     void readVariablesSwitches(QString path);
     void readTilesets(QString path);
     void readSystem(QString path);
+    void getFiles(QString path,
+                  QList<QPair<QString, Serializable*>>& files) const;
     void write(QString path);
     void writeTilesets(QString path);
     void writeSystem(QString path);
+    static void addFile(QList<QPair<QString, Serializable*>>& files,
+                        QString path, QString fileName, Serializable* datas);
 
 private:
     CommonEventsDatas* m_commonEventsDatas;
@@ -0,0 +1,132 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "binaryserializable.h"
+
+// "RPMB" read as a little endian integer
+const quint32 BinarySerializable::MAGIC = 0x424D5052;
+const quint16 BinarySerializable::VERSION = 1;
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+BinaryPalette::BinaryPalette()
+{
+
+}
+
+quint32 BinaryPalette::rectIndex(const QRect& rect) {
+    QPair<QPair<int, int>, QPair<int, int>> key(
+                QPair<int, int>(rect.left(), rect.top()),
+                QPair<int, int>(rect.width(), rect.height()));
+    QHash<QPair<QPair<int, int>, QPair<int, int>>, quint32>::const_iterator
+            it = m_rectsIndexes.find(key);
+    if (it != m_rectsIndexes.end())
+        return it.value();
+
+    quint32 index = m_rects.size();
+    m_rects.append(rect);
+    m_rectsIndexes.insert(key, index);
+
+    return index;
+}
+
+quint32 BinaryPalette::stringIndex(const QString& string) {
+    QHash<QString, quint32>::const_iterator it = m_stringsIndexes.find(string);
+    if (it != m_stringsIndexes.end())
+        return it.value();
+
+    quint32 index = m_strings.size();
+    m_strings.append(string);
+    m_stringsIndexes.insert(string, index);
+
+    return index;
+}
+
+QRect BinaryPalette::rect(quint32 index) const {
+    return index < (quint32) m_rects.size() ? m_rects.at(index) : QRect();
+}
+
+QString BinaryPalette::string(quint32 index) const {
+    return index < (quint32) m_strings.size() ? m_strings.at(index) : QString();
+}
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+void BinaryPalette::clear() {
+    m_rects.clear();
+    m_rectsIndexes.clear();
+    m_strings.clear();
+    m_stringsIndexes.clear();
+}
+
+// -------------------------------------------------------
+//
+//  READ / WRITE
+//
+// -------------------------------------------------------
+
+void BinaryPalette::read(QDataStream& stream) {
+    quint32 count;
+    qint32 x, y, width, height;
+    QByteArray bytes;
+
+    clear();
+
+    // Rects
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        stream >> x >> y >> width >> height;
+        m_rects.append(QRect(x, y, width, height));
+    }
+
+    // Strings
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        stream >> bytes;
+        m_strings.append(QString::fromUtf8(bytes));
+    }
+}
+
+// -------------------------------------------------------
+
+void BinaryPalette::write(QDataStream& stream) const {
+
+    // Rects
+    stream << (quint32) m_rects.size();
+    for (int i = 0; i < m_rects.size(); i++) {
+        const QRect& rect = m_rects.at(i);
+        stream << (qint32) rect.left() << (qint32) rect.top()
+               << (qint32) rect.width() << (qint32) rect.height();
+    }
+
+    // Strings
+    stream << (quint32) m_strings.size();
+    for (int i = 0; i < m_strings.size(); i++)
+        stream << m_strings.at(i).toUtf8();
+}
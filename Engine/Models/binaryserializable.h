@@ -0,0 +1,81 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BINARYSERIALIZABLE_H
+#define BINARYSERIALIZABLE_H
+
+#include <QDataStream>
+#include <QHash>
+#include <QPair>
+#include <QRect>
+#include <QStringList>
+#include <QVector>
+
+// -------------------------------------------------------
+//
+//  CLASS BinaryPalette
+//
+//  Shared tables of a binary file. Texture rects and strings are
+//  written only once and referenced by index in the typed arrays.
+//
+// -------------------------------------------------------
+
+class BinaryPalette
+{
+public:
+    BinaryPalette();
+    quint32 rectIndex(const QRect& rect);
+    quint32 stringIndex(const QString& string);
+    QRect rect(quint32 index) const;
+    QString string(quint32 index) const;
+    void clear();
+
+    void read(QDataStream& stream);
+    void write(QDataStream& stream) const;
+
+protected:
+    QVector<QRect> m_rects;
+    QHash<QPair<QPair<int, int>, QPair<int, int>>, quint32> m_rectsIndexes;
+    QStringList m_strings;
+    QHash<QString, quint32> m_stringsIndexes;
+};
+
+// -------------------------------------------------------
+//
+//  CLASS BinarySerializable
+//
+//  All the classes that can be written/read with the compact binary
+//  format should inherit this class in order to call
+//  Wanok::readBinary and Wanok::writeBinary methods.
+//
+// -------------------------------------------------------
+
+class BinarySerializable
+{
+public:
+    const static quint32 MAGIC;
+    const static quint16 VERSION;
+
+    virtual void readBinary(QDataStream& stream,
+                            const BinaryPalette& palette) = 0;
+    virtual void writeBinary(QDataStream& stream,
+                             BinaryPalette& palette) const = 0;
+};
+
+#endif // BINARYSERIALIZABLE_H
@@ -21,6 +21,12 @@
 #include "wanok.h"
 #include <QDir>
 
+const int EngineSettings::PREFETCH_DEPTH = 1;
+const int EngineSettings::PREFETCH_DEPTH_MAX = 8;
+const int EngineSettings::CACHE_MEMORY = 128;
+const int EngineSettings::CACHE_MEMORY_MIN = 16;
+const int EngineSettings::CACHE_MEMORY_MAX = 4096;
+
 // -------------------------------------------------------
 //
 //  CONSTRUCTOR / DESTRUCTOR / GET / SET
@@ -28,7 +34,11 @@
 // -------------------------------------------------------
 
 EngineSettings::EngineSettings() :
-    m_keyBoardDatas(new KeyBoardDatas)
+    m_keyBoardDatas(new KeyBoardDatas),
+    m_prefetchDepth(PREFETCH_DEPTH),
+    m_cacheMemory(CACHE_MEMORY),
+    m_showStatistics(false),
+    m_continuousRendering(false)
 {
 
 }
@@ -52,6 +62,30 @@ KeyBoardDatas* EngineSettings::keyBoardDatas() const {
     return m_keyBoardDatas;
 }
 
+int EngineSettings::prefetchDepth() const { return m_prefetchDepth; }
+
+void EngineSettings::setPrefetchDepth(int d) {
+    m_prefetchDepth = qBound(1, d, PREFETCH_DEPTH_MAX);
+}
+
+int EngineSettings::cacheMemory() const { return m_cacheMemory; }
+
+void EngineSettings::setCacheMemory(int m) {
+    m_cacheMemory = qBound(CACHE_MEMORY_MIN, m, CACHE_MEMORY_MAX);
+}
+
+bool EngineSettings::showStatistics() const { return m_showStatistics; }
+
+void EngineSettings::setShowStatistics(bool b) { m_showStatistics = b; }
+
+bool EngineSettings::continuousRendering() const {
+    return m_continuousRendering;
+}
+
+void EngineSettings::setContinuousRendering(bool b) {
+    m_continuousRendering = b;
+}
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
@@ -60,6 +94,10 @@ KeyBoardDatas* EngineSettings::keyBoardDatas() const {
 
 void EngineSettings::setDefault(){
     m_keyBoardDatas->setDefaultEngine();
+    m_prefetchDepth = PREFETCH_DEPTH;
+    m_cacheMemory = CACHE_MEMORY;
+    m_showStatistics = false;
+    m_continuousRendering = false;
 }
 
 // -------------------------------------------------------
@@ -70,6 +108,16 @@ void EngineSettings::setDefault(){
 
 void EngineSettings::read(const QJsonObject &json){
     m_keyBoardDatas->read(json["kb"].toObject());
+
+    // Number of slabs, and megabytes of cached portions
+    if (json.contains("prefetchDepth"))
+        setPrefetchDepth(json["prefetchDepth"].toInt(PREFETCH_DEPTH));
+    if (json.contains("cacheMemory"))
+        setCacheMemory(json["cacheMemory"].toInt(CACHE_MEMORY));
+    if (json.contains("showStatistics"))
+        m_showStatistics = json["showStatistics"].toBool();
+    if (json.contains("continuousRendering"))
+        m_continuousRendering = json["continuousRendering"].toBool();
 }
 
 // -------------------------------------------------------
@@ -79,4 +127,8 @@ void EngineSettings::write(QJsonObject &json) const{
 
     m_keyBoardDatas->write(obj);
     json["kb"] = obj;
+    json["prefetchDepth"] = m_prefetchDepth;
+    json["cacheMemory"] = m_cacheMemory;
+    json["showStatistics"] = m_showStatistics;
+    json["continuousRendering"] = m_continuousRendering;
 }
@@ -26,7 +26,8 @@
 //
 //  CLASS EngineSettings
 //
-//  The engine settings (keyboard for the engine).
+//  The engine settings (keyboard for the engine, portions streaming,
+//  map editor rendering).
 //
 // -------------------------------------------------------
 
@@ -35,9 +36,22 @@ class EngineSettings : public Serializable
 public:
     EngineSettings();
     virtual ~EngineSettings();
+    const static int PREFETCH_DEPTH;
+    const static int PREFETCH_DEPTH_MAX;
+    const static int CACHE_MEMORY;
+    const static int CACHE_MEMORY_MIN;
+    const static int CACHE_MEMORY_MAX;
     void read();
     void write();
     KeyBoardDatas* keyBoardDatas() const;
+    int prefetchDepth() const;
+    void setPrefetchDepth(int d);
+    int cacheMemory() const;
+    void setCacheMemory(int m);
+    bool showStatistics() const;
+    void setShowStatistics(bool b);
+    bool continuousRendering() const;
+    void setContinuousRendering(bool b);
     void setDefault();
 
     virtual void read(const QJsonObject &json);
@@ -45,6 +59,10 @@ public:
 
 protected:
     KeyBoardDatas* m_keyBoardDatas;
+    int m_prefetchDepth;
+    int m_cacheMemory;
+    bool m_showStatistics;
+    bool m_continuousRendering;
 };
 
 #endif // ENGINESETTINGS_H
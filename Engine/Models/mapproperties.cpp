@@ -35,7 +35,8 @@ MapProperties::MapProperties() :
 
 }
 
-MapProperties::MapProperties(QString path)
+MapProperties::MapProperties(QString path) :
+    m_isTexturesUsedKnown(true)
 {
     Wanok::readJSON(Wanok::pathCombine(path, Wanok::fileMapInfos), *this);
 }
@@ -47,7 +48,8 @@ MapProperties::MapProperties(int i, LangsTranslation* names, int l, int w,
     m_length(l),
     m_width(w),
     m_height(h),
-    m_depth(d)
+    m_depth(d),
+    m_isTexturesUsedKnown(true)
 {
 
 }
@@ -112,6 +114,43 @@ void MapProperties::removeOverflow(Position& p, Portion& portion) {
     }
 }
 
+bool MapProperties::getTexturesUsed(QSet<int>& characters,
+                                    QSet<int>& walls) const
+{
+    QHash<Portion, QSet<int>>::const_iterator i;
+    for (i = m_charactersUsed.begin(); i != m_charactersUsed.end(); i++)
+        characters.unite(i.value());
+    for (i = m_wallsUsed.begin(); i != m_wallsUsed.end(); i++)
+        walls.unite(i.value());
+
+    return m_isTexturesUsedKnown;
+}
+
+bool MapProperties::setTexturesUsed(Portion& portion, QSet<int>& characters,
+                                    QSet<int>& walls)
+{
+    if (m_charactersUsed.value(portion) == characters &&
+        m_wallsUsed.value(portion) == walls)
+    {
+        return false;
+    }
+
+    if (characters.isEmpty())
+        m_charactersUsed.remove(portion);
+    else
+        m_charactersUsed.insert(portion, characters);
+    if (walls.isEmpty())
+        m_wallsUsed.remove(portion);
+    else
+        m_wallsUsed.insert(portion, walls);
+
+    return true;
+}
+
+void MapProperties::setIsTexturesUsedKnown(bool b) {
+    m_isTexturesUsedKnown = b;
+}
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
@@ -214,6 +253,26 @@ void MapProperties::read(const QJsonObject &json){
         }
         m_outOverflowSprites.insert(portion, positions);
     }
+
+    // Textures used (maps saved before don't have the list)
+    m_isTexturesUsedKnown = json.contains("textures");
+    m_charactersUsed.clear();
+    m_wallsUsed.clear();
+    QJsonArray tabTextures = json["textures"].toArray();
+    for (int i = 0; i < tabTextures.size(); i++) {
+        QJsonObject objHash = tabTextures.at(i).toObject();
+        QJsonArray tabKey = objHash["k"].toArray();
+        QJsonArray tabCharacters = objHash["c"].toArray();
+        QJsonArray tabWalls = objHash["w"].toArray();
+        Portion portion;
+        portion.read(tabKey);
+        QSet<int> characters, walls;
+        for (int j = 0; j < tabCharacters.size(); j++)
+            characters.insert(tabCharacters.at(j).toInt());
+        for (int j = 0; j < tabWalls.size(); j++)
+            walls.insert(tabWalls.at(j).toInt());
+        setTexturesUsed(portion, characters, walls);
+    }
 }
 
 // -------------------------------------------------------
@@ -252,4 +311,38 @@ void MapProperties::write(QJsonObject &json) const{
         tabOverflow.append(objHash);
     }
     json["ofsprites"] = tabOverflow;
+
+    // Textures used: only written once complete, a partial list would
+    // prevent the other pictures from being preloaded
+    if (!m_isTexturesUsedKnown)
+        return;
+    QSet<Portion> portions = m_charactersUsed.keys().toSet() +
+            m_wallsUsed.keys().toSet();
+    QJsonArray tabTextures;
+    for (QSet<Portion>::iterator j = portions.begin(); j != portions.end();
+         j++)
+    {
+        Portion portion = *j;
+        QJsonObject objHash;
+        QJsonArray tabKey;
+        QJsonArray tabCharacters;
+        QJsonArray tabWalls;
+
+        portion.write(tabKey);
+        QSet<int> characters = m_charactersUsed.value(portion);
+        for (QSet<int>::iterator k = characters.begin();
+             k != characters.end(); k++)
+        {
+            tabCharacters.append(*k);
+        }
+        QSet<int> walls = m_wallsUsed.value(portion);
+        for (QSet<int>::iterator k = walls.begin(); k != walls.end(); k++)
+            tabWalls.append(*k);
+
+        objHash["k"] = tabKey;
+        objHash["c"] = tabCharacters;
+        objHash["w"] = tabWalls;
+        tabTextures.append(objHash);
+    }
+    json["textures"] = tabTextures;
 }
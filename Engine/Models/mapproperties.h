@@ -55,6 +55,10 @@ public:
     void setDepth(int d);
     void addOverflow(Position& p, Portion& portion);
     void removeOverflow(Position& p, Portion& portion);
+    bool getTexturesUsed(QSet<int>& characters, QSet<int>& walls) const;
+    bool setTexturesUsed(Portion& portion, QSet<int>& characters,
+                         QSet<int>& walls);
+    void setIsTexturesUsedKnown(bool b);
 
     bool isInGrid(Position3D& position, int squareSize) const;
     void getPortionsNumber(int& lx, int& ly, int& lz);
@@ -74,6 +78,9 @@ protected:
     int m_height;
     int m_depth;
     QHash<Portion, QSet<Position>*> m_outOverflowSprites;
+    QHash<Portion, QSet<int>> m_charactersUsed;
+    QHash<Portion, QSet<int>> m_wallsUsed;
+    bool m_isTexturesUsedKnown;
 };
 
 #endif // MAPPROPERTIES_H
@@ -25,6 +25,10 @@
 #include <QDirIterator>
 #include <QMessageBox>
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDebug>
+#include <QtConcurrent>
 
 const QString Project::ENGINE_VERSION = "0.4.0";
 
@@ -43,7 +47,8 @@ Project::Project() :
     m_scriptsDatas(new ScriptsDatas),
     m_picturesDatas(new PicturesDatas),
     m_keyBoardDatas(new KeyBoardDatas),
-    m_specialElementsDatas(new SpecialElementsDatas)
+    m_specialElementsDatas(new SpecialElementsDatas),
+    m_isSaving(false)
 {
 
 }
@@ -94,6 +99,8 @@ SpecialElementsDatas* Project::specialElementsDatas() const {
 
 QString Project::version() const { return m_version; }
 
+bool Project::isSaving() const { return m_isSaving; }
+
 // -------------------------------------------------------
 //
 //  INTERMEDIARY FUNCTIONS
@@ -112,9 +119,14 @@ void Project::setDefault(){
 
 // -------------------------------------------------------
 
-void Project::saveCurrentMap(){
-    p_currentMap->save();
+bool Project::saveCurrentMap(){
+    QList<QPair<QString, Serializable*>> files;
+    if (!save(new ProjectSaver(files, p_currentMap)))
+        return false;
+
     p_currentMap->setSaved(true);
+
+    return true;
 }
 
 // -------------------------------------------------------
@@ -132,13 +144,7 @@ bool Project::read(QString path){
     if (!readOS())
         return false;
 
-    readLangsDatas();
-    readKeyBoardDatas();
-    readPicturesDatas();
-    readGameDatas();
-    readTreeMapDatas();
-    readScriptsDatas();
-    readSpecialsDatas();
+    readDatas();
     p_currentMap = nullptr;
 
     return true;
@@ -317,6 +323,46 @@ void Project::removeOSFiles() {
 
 // -------------------------------------------------------
 
+void Project::readDatas() {
+    QElapsedTimer timer;
+    timer.start();
+    QList<QPair<QString, Serializable*>> files;
+    getFiles(files);
+
+    // Parsing: the files are independent
+    QStringList paths;
+    for (int i = 0; i < files.size(); i++)
+        paths.append(files.at(i).first);
+    QList<QPair<QJsonDocument, qint64>> documents =
+            QtConcurrent::blockingMapped(paths, &Project::parseFile);
+    qint64 timeParsing = timer.elapsed();
+
+    // Filling the models, always in the same order
+    QElapsedTimer timerFile;
+    for (int i = 0; i < files.size(); i++) {
+        timerFile.start();
+        files.at(i).second->read(documents.at(i).first.object());
+        qInfo().noquote() << "Project:" << QFileInfo(paths.at(i)).fileName()
+                          << "parsed in" << documents.at(i).second
+                          << "ms, read in" << timerFile.elapsed() << "ms";
+    }
+    qInfo().noquote() << "Project: datas parsed in" << timeParsing
+                      << "ms, loaded in" << timer.elapsed() << "ms";
+}
+
+// -------------------------------------------------------
+
+QPair<QJsonDocument, qint64> Project::parseFile(const QString& path) {
+    QElapsedTimer timer;
+    timer.start();
+    QJsonDocument document;
+    Wanok::readOtherJSON(path, document);
+
+    return QPair<QJsonDocument, qint64>(document, timer.elapsed());
+}
+
+// -------------------------------------------------------
+
 void Project::readGameDatas(){
     p_gameDatas->read(p_pathCurrentProject);
 }
@@ -371,15 +417,65 @@ void Project::readTilesetsDatas() {
 
 // -------------------------------------------------------
 
+void Project::getFiles(QList<QPair<QString, Serializable*>>& files) const {
+    QString path = p_pathCurrentProject;
+
+    // In the reading order: some models need the previous ones
+    GameDatas::addFile(files, path, Wanok::pathLangs, m_langsDatas);
+    GameDatas::addFile(files, path, Wanok::pathKeyBoard, m_keyBoardDatas);
+    GameDatas::addFile(files, path, Wanok::pathPicturesDatas,
+                       m_picturesDatas);
+    p_gameDatas->getFiles(path, files);
+    GameDatas::addFile(files, path, Wanok::pathTreeMap, m_treeMapDatas);
+    GameDatas::addFile(files, path, Wanok::pathScripts, m_scriptsDatas);
+    GameDatas::addFile(files, path, Wanok::PATH_SPECIAL_ELEMENTS,
+                       m_specialElementsDatas);
+}
+
+// -------------------------------------------------------
+
+bool Project::save(ProjectSaver* worker) {
+
+    // The dialog event loop could start another save
+    if (m_isSaving) {
+        delete worker;
+        return false;
+    }
+    m_isSaving = true;
+
+    DialogProgress dialog;
+    QThread thread;
+    worker->moveToThread(&thread);
+    qApp->connect(&thread, SIGNAL(started()), worker, SLOT(save()));
+    qApp->connect(worker, SIGNAL(finished()), &dialog, SLOT(accept()));
+    qApp->connect(worker, SIGNAL(progress(int, QString)),
+                  &dialog, SLOT(setValueLabel(int, QString)));
+    qApp->connect(&dialog, SIGNAL(rejected()), worker, SLOT(cancel()),
+                  Qt::DirectConnection);
+    thread.start();
+    dialog.exec();
+
+    // If the dialog was closed, the files being written are still finished
+    // before all the temporary files are removed
+    thread.quit();
+    thread.wait();
+    bool saved = worker->isComplete();
+    delete worker;
+    m_isSaving = false;
+
+    return saved;
+}
+
+// -------------------------------------------------------
+
 void Project::write(QString path){
     setPathCurrentProject(path);
-    writeLangsDatas();
-    writeKeyBoardDatas();
-    writePicturesDatas();
-    writeSpecialsDatas();
-    writeGameDatas();
-    writeTreeMapDatas();
-    writeScriptsDatas();
+
+    // A new project is small: saved right away, without any dialog
+    QList<QPair<QString, Serializable*>> files;
+    getFiles(files);
+    ProjectSaver saver(files);
+    saver.save();
 }
 
 // -------------------------------------------------------
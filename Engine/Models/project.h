@@ -20,6 +20,7 @@
 #ifndef PROJECT_H
 #define PROJECT_H
 
+#include <QJsonDocument>
 #include "map.h"
 #include "gamedatas.h"
 #include "treemapdatas.h"
@@ -28,6 +29,7 @@
 #include "picturesdatas.h"
 #include "keyboarddatas.h"
 #include "specialelementsdatas.h"
+#include "projectsaver.h"
 
 // -------------------------------------------------------
 //
@@ -57,10 +59,13 @@ public:
     KeyBoardDatas* keyBoardDatas() const;
     SpecialElementsDatas* specialElementsDatas() const;
     QString version() const;
+    bool isSaving() const;
 
     bool read(QString path);
     bool readVersion();
     bool readOS();
+    void readDatas();
+    static QPair<QJsonDocument, qint64> parseFile(const QString& path);
     bool copyOSFiles();
     void removeOSFiles();
     void readGameDatas();
@@ -72,6 +77,8 @@ public:
     void readSpecialsDatas();
     void readSystemDatas();
     void readTilesetsDatas();
+    void getFiles(QList<QPair<QString, Serializable*>>& files) const;
+    bool save(ProjectSaver* worker);
     void write(QString path);
     void writeGameDatas();
     void writeLangsDatas();
@@ -82,7 +89,7 @@ public:
     void writeSpecialsDatas();
     void writeSystemDatas();
     void writeTilesetsDatas();
-    void saveCurrentMap();
+    bool saveCurrentMap();
     QString createRPMFile();
 
 private:
@@ -97,6 +104,7 @@ private:
     KeyBoardDatas* m_keyBoardDatas;
     SpecialElementsDatas* m_specialElementsDatas;
     QString m_version;
+    bool m_isSaving;
 };
 
 #endif // PROJECT_H
@@ -0,0 +1,197 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtConcurrent>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include "projectsaver.h"
+#include "map.h"
+#include "wanok.h"
+
+const QString ProjectSaver::EXTENSION_TEMP = ".save";
+const QString ProjectSaver::EXTENSION_BACKUP = ".backup";
+
+// -------------------------------------------------------
+//
+//  CONSTRUCTOR / DESTRUCTOR / GET / SET
+//
+// -------------------------------------------------------
+
+ProjectSaver::ProjectSaver(QList<QPair<QString, Serializable*>>& files,
+                           Map* map) :
+    m_map(map),
+    m_written(0),
+    m_canceled(0),
+    m_failed(0),
+    m_complete(false)
+{
+    // Snapshot of the models, taken on the GUI thread
+    for (int i = 0; i < files.size(); i++) {
+        QJsonObject json;
+        files.at(i).second->write(json);
+        m_files.append(QPair<QString, QJsonObject>(files.at(i).first, json));
+    }
+}
+
+ProjectSaver::~ProjectSaver()
+{
+
+}
+
+int ProjectSaver::count() const {
+
+    // The map counts as one more step
+    return m_files.size() + (m_map != nullptr ? 1 : 0);
+}
+
+bool ProjectSaver::isCanceled() const { return m_canceled.load() != 0; }
+
+bool ProjectSaver::isComplete() const { return m_complete; }
+
+// -------------------------------------------------------
+//
+//  INTERMEDIARY FUNCTIONS
+//
+// -------------------------------------------------------
+
+QString ProjectSaver::getTempPath(const QString& path) {
+    return path + EXTENSION_TEMP;
+}
+
+// -------------------------------------------------------
+
+QString ProjectSaver::getBackupPath(const QString& path) {
+    return path + EXTENSION_BACKUP;
+}
+
+// -------------------------------------------------------
+
+void ProjectSaver::writeFile(const QPair<QString, QJsonObject>& file) {
+    if (isCanceled() || m_failed.load() != 0)
+        return;
+
+    QFile saveFile(getTempPath(file.first));
+    QByteArray data = QJsonDocument(file.second).toJson(
+                QJsonDocument::Compact);
+    if (!saveFile.open(QIODevice::WriteOnly) ||
+        saveFile.write(data) != data.size() || !saveFile.flush())
+    {
+        m_failed.store(1);
+        return;
+    }
+    saveFile.close();
+    m_written.fetchAndAddOrdered(1);
+    updateProgress("Saving " + QFileInfo(file.first).fileName() + "...");
+}
+
+// -------------------------------------------------------
+
+bool ProjectSaver::replaceFiles() {
+    for (int i = 0; i < m_files.size(); i++) {
+        QString path = m_files.at(i).first;
+        QString pathBackup = getBackupPath(path);
+        QFile::remove(pathBackup);
+        if (QFile(path).exists() && !QFile::rename(path, pathBackup)) {
+            restoreFiles(i);
+            return false;
+        }
+        if (!QFile::rename(getTempPath(path), path)) {
+            QFile::rename(pathBackup, path);
+            restoreFiles(i);
+            return false;
+        }
+    }
+
+    // Every file is replaced: the backups are not needed anymore
+    for (int i = 0; i < m_files.size(); i++)
+        QFile::remove(getBackupPath(m_files.at(i).first));
+
+    return true;
+}
+
+// -------------------------------------------------------
+
+void ProjectSaver::restoreFiles(int count) {
+
+    // The new versions go back to temp, in case a backup can't be restored
+    for (int i = 0; i < count; i++) {
+        QString path = m_files.at(i).first;
+        QString pathBackup = getBackupPath(path);
+        QFile::rename(path, getTempPath(path));
+        if (QFile(pathBackup).exists())
+            QFile::rename(pathBackup, path);
+    }
+}
+
+// -------------------------------------------------------
+
+void ProjectSaver::removeTempFiles() {
+    for (int i = 0; i < m_files.size(); i++) {
+        QString path = m_files.at(i).first;
+
+        // Only left if it is the last version of a file still in backup
+        if (QFile(path).exists() || !QFile(getBackupPath(path)).exists())
+            QFile::remove(getTempPath(path));
+    }
+}
+
+// -------------------------------------------------------
+
+void ProjectSaver::updateProgress(QString text) {
+    int total = count();
+
+    emit progress(total == 0 ? 100 : m_written.load() * 100 / total, text);
+}
+
+// -------------------------------------------------------
+//
+//  SLOTS
+//
+// -------------------------------------------------------
+
+void ProjectSaver::save() {
+    updateProgress("Saving the project...");
+
+    // Called in the thread pool, the signals are queued to the dialog
+    typedef QPair<QString, QJsonObject> File;
+    QtConcurrent::blockingMap(m_files, [this](const File& file) {
+        writeFile(file);
+    });
+
+    // The previous files are only replaced once all of them are written
+    bool filesSaved = m_written.load() == m_files.size() && replaceFiles();
+    removeTempFiles();
+
+    // The map save is journaled: it is done entirely or not at all
+    if (filesSaved && m_map != nullptr && !isCanceled()) {
+        updateProgress("Saving the map...");
+        m_map->save();
+        m_written.fetchAndAddOrdered(1);
+    }
+    m_complete = filesSaved && m_written.load() == count();
+    updateProgress(m_complete ? "Done" : "The project could not be saved");
+
+    emit finished();
+}
+
+// -------------------------------------------------------
+
+void ProjectSaver::cancel() {
+    m_canceled.store(1);
+}
@@ -0,0 +1,84 @@
+/*
+    RPG Paper Maker Copyright (C) 2017 Marie Laporte
+
+    This file is part of RPG Paper Maker.
+
+    RPG Paper Maker is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RPG Paper Maker is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROJECTSAVER_H
+#define PROJECTSAVER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QJsonObject>
+#include "serializable.h"
+
+class Map;
+
+// -------------------------------------------------------
+//
+//  CLASS ProjectSaver
+//
+//  Module used for saving a project in a background thread. The
+//  datas are copied into json objects on the GUI thread when the saver
+//  is created, so that the models can't change while the files are
+//  written. The files are first written in parallel next to the
+//  previous ones, and only replace them once every file is written.
+//  The previous files are kept as backups until all of them are
+//  replaced, so that a cancelled or failed save leaves the project
+//  untouched. The map, if any, is saved last through its journal.
+//
+// -------------------------------------------------------
+
+class ProjectSaver : public QObject
+{
+    Q_OBJECT
+public:
+    ProjectSaver(QList<QPair<QString, Serializable*>>& files,
+                 Map* map = nullptr);
+    virtual ~ProjectSaver();
+    const static QString EXTENSION_TEMP;
+    const static QString EXTENSION_BACKUP;
+
+    int count() const;
+    bool isCanceled() const;
+    bool isComplete() const;
+
+protected:
+    QList<QPair<QString, QJsonObject>> m_files;
+    Map* m_map;
+    QAtomicInt m_written;
+    QAtomicInt m_canceled;
+    QAtomicInt m_failed;
+    bool m_complete;
+
+    static QString getTempPath(const QString& path);
+    static QString getBackupPath(const QString& path);
+    void writeFile(const QPair<QString, QJsonObject>& file);
+    bool replaceFiles();
+    void restoreFiles(int count);
+    void removeTempFiles();
+    void updateProgress(QString text);
+
+public slots:
+    void save();
+    void cancel();
+
+signals:
+    void progress(int, QString);
+    void finished();
+};
+
+#endif // PROJECTSAVER_H
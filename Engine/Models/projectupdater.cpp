@@ -20,11 +20,13 @@
 #include "projectupdater.h"
 #include "wanok.h"
 #include <QDirIterator>
+#include <QtConcurrent>
 
 const int ProjectUpdater::incompatibleVersionsCount = 2;
 
 QString ProjectUpdater::incompatibleVersions[incompatibleVersionsCount]
     {"0.3.1", "0.4.0"};
+const int ProjectUpdater::MAX_PORTIONS_IN_FLIGHT = 32;
 
 // -------------------------------------------------------
 //
@@ -34,15 +36,15 @@ QString ProjectUpdater::incompatibleVersions[incompatibleVersionsCount]
 
 ProjectUpdater::ProjectUpdater(Project* project, QString previous) :
     m_project(project),
-    m_previousFolderName(previous)
+    m_previousFolderName(previous),
+    m_portionsInFlight(MAX_PORTIONS_IN_FLIGHT)
 {
 
 }
 
 ProjectUpdater::~ProjectUpdater()
 {
-    clearListMapPaths();
-    clearListMapPortions();
+
 }
 
 // -------------------------------------------------------
@@ -109,82 +111,194 @@ int ProjectUpdater::versionDifferent(QString projectVersion,
 
 // -------------------------------------------------------
 
-void ProjectUpdater::clearListMapPaths() {
-    for (int i = 0; i < m_listMapPortionsPaths.size(); i++)
-        delete m_listMapPortionsPaths.at(i);
-    m_listMapPortionsPaths.clear();
+QString ProjectUpdater::pathPreviousProject() const {
+    QDir dirProject(m_project->pathCurrentProject());
+    dirProject.cdUp();
+
+    return Wanok::pathCombine(dirProject.path(), m_previousFolderName);
 }
 
 // -------------------------------------------------------
 
-void ProjectUpdater::clearListMapPortions() {
-    for (int i = 0; i < m_listMapPortions.size(); i++)
-        delete m_listMapPortions.at(i);
-    m_listMapPortions.clear();
+void ProjectUpdater::copyPreviousProject() {
+    QString path = pathPreviousProject();
+    QDir(path).mkpath(Wanok::pathMaps);
+
+    // The maps are copied one by one, while converting the previous ones
+    Wanok::copyPath(m_project->pathCurrentProject(), path,
+                    Wanok::pathCombine(m_project->pathCurrentProject(),
+                                       Wanok::pathMaps));
 }
 
 // -------------------------------------------------------
 
-void ProjectUpdater::copyPreviousProject() {
-    QDir dirProject(m_project->pathCurrentProject());
-    dirProject.cdUp();
-    QDir(dirProject.path()).mkdir(m_previousFolderName);
-    Wanok::copyPath(m_project->pathCurrentProject(),
-                    Wanok::pathCombine(dirProject.path(),
-                                       m_previousFolderName));
+QFuture<bool> ProjectUpdater::copyPreviousMap(QString mapName) {
+    QString pathMap = Wanok::pathCombine(Wanok::pathMaps, mapName);
+    QString pathPrevious = Wanok::pathCombine(pathPreviousProject(), pathMap);
+    QDir(pathPreviousProject()).mkpath(pathMap);
+
+    return QtConcurrent::run(&Wanok::copyPath,
+                             Wanok::pathCombine(
+                                 m_project->pathCurrentProject(), pathMap),
+                             pathPrevious, QString());
 }
 
 // -------------------------------------------------------
 
-void ProjectUpdater::getAllPathsMapsPortions()
-{
+void ProjectUpdater::getMapsNames(QStringList& names) const {
     QString pathMaps = Wanok::pathCombine(m_project->pathCurrentProject(),
                                           Wanok::pathMaps);
     QDirIterator directories(pathMaps, QDir::Dirs | QDir::NoDotAndDotDot);
 
-    // Clear
-    m_listMapProperties.clear();
-    m_listMapPropertiesPaths.clear();
-    clearListMapPaths();
-    clearListMapPortions();
-
-    // Fill
     while (directories.hasNext()) {
         directories.next();
-        QString mapName = directories.fileName();
-        if (mapName != "temp") {
-            QDirIterator files(Wanok::pathCombine(pathMaps, mapName),
-                               QDir::Files);
-            QList<QJsonObject>* mapPortions = new QList<QJsonObject>;
-            QList<QString>* paths = new QList<QString>;
-            m_listMapPortions.append(mapPortions);
-            m_listMapPortionsPaths.append(paths);
-
-            while (files.hasNext()) {
-                files.next();
-                QString fileName = files.fileName();
-                QString path = files.filePath();
-                QJsonDocument document;
-                if (fileName == "infos.json") {
-                    Wanok::readOtherJSON(path, document);
-                    m_listMapProperties.append(document.object());
-                    m_listMapPropertiesPaths.append(path);
-                }
-                else if (fileName != "objects.json") {
-                    Wanok::readOtherJSON(path, document);
-                    paths->append(path);
-                    mapPortions->append(document.object());
-                }
-            }
+        if (directories.fileName() != Wanok::TEMP_MAP_FOLDER_NAME)
+            names.append(directories.fileName());
+    }
+    names.sort();
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updateMaps(QStringList& versions) {
+    QStringList names;
+    getMapsNames(names);
+
+    QFuture<bool> copy;
+    if (!names.isEmpty())
+        copy = copyPreviousMap(names.at(0));
+    for (int i = 0; i < names.size(); i++) {
+        emit progress(10 + (80 * i / names.size()),
+                      "Updating " + names.at(i) + " (" +
+                      QString::number(i + 1) + "/" +
+                      QString::number(names.size()) + ")...");
+
+        // The previous version of the map has to be kept before converting
+        copy.waitForFinished();
+        if (i + 1 < names.size())
+            copy = copyPreviousMap(names.at(i + 1));
+        updateMap(names.at(i), versions);
+    }
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updateMap(QString mapName, QStringList& versions) {
+    QString pathMap = Wanok::pathCombine(
+                Wanok::pathCombine(m_project->pathCurrentProject(),
+                                   Wanok::pathMaps), mapName);
+    QDirIterator files(pathMap, QDir::Files);
+
+    while (files.hasNext()) {
+        files.next();
+        QString fileName = files.fileName();
+        QString path = files.filePath();
+        if (fileName == Wanok::fileMapInfos)
+            updateMapProperties(path, versions);
+        else if (fileName != Wanok::fileMapObjects &&
+                 fileName.endsWith(".json"))
+        {
+            // Wait for a free slot before reading another portion
+            m_portionsInFlight.acquire();
+            QtConcurrent::run([this, path, versions]() {
+                updatePortion(path, versions);
+                m_portionsInFlight.release();
+            });
         }
     }
+
+    // All the portions of the map are done
+    m_portionsInFlight.acquire(MAX_PORTIONS_IN_FLIGHT);
+    m_portionsInFlight.release(MAX_PORTIONS_IN_FLIGHT);
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updateMapProperties(QString path, QStringList versions) {
+    QJsonDocument document;
+    Wanok::readOtherJSON(path, document);
+    QJsonObject obj = document.object();
+
+    if (versions.contains("0.4.0"))
+        updateMapProperties_0_4_0(obj);
+    Wanok::writeOtherJSON(path, obj);
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updatePortion(QString path, QStringList versions) {
+    QJsonDocument document;
+    Wanok::readOtherJSON(path, document);
+    QJsonObject obj = document.object();
+
+    // A file that can't be read is left as it is
+    if (document.isNull())
+        return;
+
+    // As before the streamed update, the files of empty portions are
+    // removed. The editor (Map::readPortion) and the game (SceneMap) read
+    // a missing portion as an empty one, and the previous project keeps a
+    // copy of the file
+    if (obj.isEmpty()) {
+        QFile(path).remove();
+        return;
+    }
+
+    for (int i = 0; i < versions.size(); i++) {
+        if (versions.at(i) == "0.3.1")
+            updatePortion_0_3_1(obj);
+        else if (versions.at(i) == "0.4.0")
+            updatePortion_0_4_0(obj);
+    }
+    Wanok::writeOtherJSON(path, obj);
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updateMapProperties_0_4_0(QJsonObject& obj) {
+    obj["ofsprites"] = QJsonArray();
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updatePortion_0_3_1(QJsonObject& obj) {
+    QJsonObject objSprites = obj["sprites"].toObject();
+    QJsonArray tabSprites = objSprites["list"].toArray();
+
+    for (int k = 0; k < tabSprites.size(); k++) {
+        QJsonObject objSprite = tabSprites.at(k).toObject();
+
+        // Replace Position3D by Position
+        QJsonArray tabKey = objSprite["k"].toArray();
+        tabKey.append(0);
+        objSprite["k"] = tabKey;
+
+        // Remove key layer from sprites objects
+        QJsonObject objVal = objSprite["v"].toArray()[0].toObject();
+        objVal.remove("l");
+        objSprite["v"] = objVal;
+
+        tabSprites[k] = objSprite;
+    }
+
+    objSprites["list"] = tabSprites;
+    obj["sprites"] = objSprites;
 }
 
 // -------------------------------------------------------
 
-void ProjectUpdater::updateVersion(QString& version) {
-    getAllPathsMapsPortions();
+void ProjectUpdater::updatePortion_0_4_0(QJsonObject& obj) {
 
+    // Add walls and overflow empty tab for sprites
+    QJsonObject objSprites = obj["sprites"].toObject();
+    objSprites["walls"] = QJsonArray();
+    objSprites["overflow"] = QJsonArray();
+    obj["sprites"] = objSprites;
+}
+
+// -------------------------------------------------------
+
+void ProjectUpdater::updateVersion(QString version) {
     QString str = "updateVersion_" + version.replace(".", "_");
     QByteArray ba = str.toLatin1();
     const char *c_str = ba.data();
@@ -227,9 +341,9 @@ void ProjectUpdater::copySystemScripts() {
 // -------------------------------------------------------
 
 void ProjectUpdater::check() {
-    emit progress(10, "Copying the previous project...");
+    emit progress(5, "Copying the previous project...");
     copyPreviousProject();
-    emit progress(80, "Checking incompatible versions...");
+    emit progress(10, "Checking incompatible versions...");
 
     // Updating for incompatible versions
     int index = incompatibleVersionsCount;
@@ -242,12 +356,17 @@ void ProjectUpdater::check() {
             break;
         }
     }
+    QStringList versions;
+    for (int i = index; i < incompatibleVersionsCount; i++)
+        versions.append(incompatibleVersions[i]);
 
-    // Updating for each version
-    for (int i = index; i < incompatibleVersionsCount; i++) {
-        emit progress(80, "Checking version " + incompatibleVersions[i] +
-                      "...");
-        updateVersion(incompatibleVersions[i]);
+    // All the versions are applied to a portion at once
+    updateMaps(versions);
+
+    // Updating the other datas for each version
+    for (int i = 0; i < versions.size(); i++) {
+        emit progress(90, "Checking version " + versions.at(i) + "...");
+        updateVersion(versions.at(i));
     }
 
     // Copy recent executable and scripts
@@ -264,36 +383,7 @@ void ProjectUpdater::check() {
 
 void ProjectUpdater::updateVersion_0_3_1() {
 
-    for (int i = 0; i < m_listMapPortions.size(); i++) {
-        QList<QJsonObject>* mapPortions = m_listMapPortions.at(i);
-        QList<QString>* paths = m_listMapPortionsPaths.at(i);
-
-        for (int j = 0; j < mapPortions->size(); j++) {
-            QJsonObject obj = mapPortions->at(j);
-            QJsonObject objSprites = obj["sprites"].toObject();
-            QJsonArray tabSprites = objSprites["list"].toArray();
-
-            for (int k = 0; k < tabSprites.size(); k++) {
-                QJsonObject objSprite = tabSprites.at(k).toObject();
-
-                // Replace Position3D by Position
-                QJsonArray tabKey = objSprite["k"].toArray();
-                tabKey.append(0);
-                objSprite["k"] = tabKey;
-
-                // Remove key layer from sprites objects
-                QJsonObject objVal = objSprite["v"].toArray()[0].toObject();
-                objVal.remove("l");
-                objSprite["v"] = objVal;
-
-                tabSprites[j] = objSprite;
-            }
-
-            objSprites["list"] = tabSprites;
-            obj["sprites"] = objSprites;
-            Wanok::writeOtherJSON(paths->at(j), obj);
-        }
-    }
+    // Only the portions changed
 }
 
 // -------------------------------------------------------
@@ -303,25 +393,6 @@ void ProjectUpdater::updateVersion_0_4_0() {
     // Create walls directory
     QDir(m_project->pathCurrentProject()).mkpath(Wanok::PATH_SPRITE_WALLS);
 
-    for (int i = 0; i < m_listMapPortions.size(); i++) {
-        QList<QJsonObject>* mapPortions = m_listMapPortions.at(i);
-        QList<QString>* paths = m_listMapPortionsPaths.at(i);
-        QJsonObject objMapProperties = m_listMapProperties.at(i);
-        objMapProperties["ofsprites"] = QJsonArray();
-        Wanok::writeOtherJSON(m_listMapPropertiesPaths.at(i), objMapProperties);
-
-        // Add walls and overflow empty tab for sprites
-        for (int j = 0; j < mapPortions->size(); j++) {
-            QJsonObject obj = mapPortions->at(j);
-            QJsonObject objSprites = obj["sprites"].toObject();
-            objSprites["walls"] = QJsonArray();
-            objSprites["overflow"] = QJsonArray();
-            obj["sprites"] = objSprites;
-
-            Wanok::writeOtherJSON(paths->at(j), obj);
-        }
-    }
-
     // Adding a default special elements datas to the project
     SpecialElementsDatas specialElementsDatas;
     specialElementsDatas.setDefault();
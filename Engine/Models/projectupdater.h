@@ -20,6 +20,8 @@
 #ifndef PROJECTUPDATER_H
 #define PROJECTUPDATER_H
 
+#include <QFuture>
+#include <QSemaphore>
 #include "project.h"
 
 // -------------------------------------------------------
@@ -27,7 +29,10 @@
 //  CLASS ProjectUpdater
 //
 //  Module used for detecting if a project needs to be updated according to
-//  the engine version.
+//  the engine version. Maps are converted one after the other, with their
+//  portions streamed through the thread pool: only a few portions are in
+//  memory at the same time. The copy of a map in the previous project is
+//  done while the map before it is converted.
 //
 // -------------------------------------------------------
 
@@ -40,24 +45,29 @@ public:
 
     static const int incompatibleVersionsCount;
     static QString incompatibleVersions[];
+    static const int MAX_PORTIONS_IN_FLIGHT;
     static bool getSubVersions(QString& version, int& m, int& f, int& b);
     static int versionDifferent(QString projectVersion, QString otherVersion
                                 = Project::ENGINE_VERSION);
-    void clearListMapPaths();
-    void clearListMapPortions();
+    QString pathPreviousProject() const;
     void copyPreviousProject();
-    void getAllPathsMapsPortions();
-    void updateVersion(QString& version);
+    QFuture<bool> copyPreviousMap(QString mapName);
+    void getMapsNames(QStringList& names) const;
+    void updateMaps(QStringList& versions);
+    void updateMap(QString mapName, QStringList& versions);
+    static void updateMapProperties(QString path, QStringList versions);
+    static void updatePortion(QString path, QStringList versions);
+    static void updateMapProperties_0_4_0(QJsonObject& obj);
+    static void updatePortion_0_3_1(QJsonObject& obj);
+    static void updatePortion_0_4_0(QJsonObject& obj);
+    void updateVersion(QString version);
     void copyExecutable();
     void copySystemScripts();
 
 protected:
     Project* m_project;
     QString m_previousFolderName;
-    QList<QJsonObject> m_listMapProperties;
-    QList<QString> m_listMapPropertiesPaths;
-    QList<QList<QJsonObject>*> m_listMapPortions;
-    QList<QList<QString>*> m_listMapPortionsPaths;
+    QSemaphore m_portionsInFlight;
 
 public slots:
     void check();
@@ -1,9 +1,8 @@
 #version 130
 
 in vec3 centerPosition;
-in vec2 texCoord0;
+in vec4 texRect;
 in vec2 size;
-in vec2 model;
 
 uniform vec3 cameraRightWorldspace;
 uniform vec3 cameraUpWorldspace; // Used for full billboard
@@ -11,13 +10,21 @@ uniform mat4 modelViewProjection;
 
 out vec2 coordTexture;
 
+// The two triangles of the quad, in texture coordinates. Instances draw
+// 6 vertices each, so the corner is also found without instancing
+const vec2 corners[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 0.0),
+                                vec2(1.0, 1.0), vec2(0.0, 0.0),
+                                vec2(1.0, 1.0), vec2(0.0, 1.0));
+
 void main()
 {
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 model = vec2(corner.x - 0.5, 0.5 - corner.y);
     vec3 vertexPositionWorldspace =
         centerPosition
         + cameraRightWorldspace * model.x * size.x
         + vec3(0.0, 1.0, 0.0) * model.y * size.y;
 
     gl_Position = modelViewProjection * vec4(vertexPositionWorldspace, 1.0);
-    coordTexture = texCoord0;
+    coordTexture = texRect.xy + corner * texRect.zw;
 }
@@ -82,9 +82,12 @@ const QString Wanok::pathEngineSettings =
         pathCombine("Content", "engineSettings.json");
 const QString Wanok::fileMapInfos = "infos.json";
 const QString Wanok::fileMapObjects = "objects.json";
+const QString Wanok::FILE_MAP_PACK = "portions.pack";
+const QString Wanok::FILE_MAP_JOURNAL = "journal.json";
 const QString Wanok::gamesFolderName = "RPG Paper Maker Games";
 const QString Wanok::TEMP_MAP_FOLDER_NAME = "temp";
 const QString Wanok::TEMP_UNDOREDO_MAP_FOLDER_NAME = "tempUndoRedo";
+const QString Wanok::EXTENSION_PORTION_BINARY = "pmb";
 const QString Wanok::dirGames = Wanok::pathCombine(
             QStandardPaths::writableLocation(
                 QStandardPaths::StandardLocation::DocumentsLocation),
@@ -212,16 +215,78 @@ void Wanok::readArrayJSON(QString path, QJsonDocument& loadDoc){
 
 // -------------------------------------------------------
 
-bool Wanok::copyPath(QString src, QString dst)
+void Wanok::writeBinary(QString path, const BinarySerializable &obj){
+    QByteArray data;
+    writeBinaryData(data, obj);
+
+    QFile saveFile(path);
+    if (!saveFile.open(QIODevice::WriteOnly)) { return; }
+    saveFile.write(data);
+}
+
+// -------------------------------------------------------
+
+bool Wanok::readBinary(QString path, BinarySerializable &obj){
+    QFile loadFile(path);
+    if (!loadFile.open(QIODevice::ReadOnly)) { return false; }
+
+    return readBinaryData(loadFile.readAll(), obj);
+}
+
+// -------------------------------------------------------
+
+void Wanok::writeBinaryData(QByteArray& data, const BinarySerializable &obj){
+    BinaryPalette palette;
+    QByteArray body;
+    QDataStream bodyStream(&body, QIODevice::WriteOnly);
+    bodyStream.setByteOrder(QDataStream::LittleEndian);
+    obj.writeBinary(bodyStream, palette);
+
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << BinarySerializable::MAGIC << BinarySerializable::VERSION
+           << (quint16) 0;
+    palette.write(stream);
+    stream.writeRawData(body.constData(), body.size());
+}
+
+// -------------------------------------------------------
+
+bool Wanok::readBinaryData(const QByteArray& data, BinarySerializable &obj){
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic;
+    quint16 version, flags;
+    stream >> magic >> version >> flags;
+
+    // Unknown files are ignored so that the json can be used instead
+    if (stream.status() != QDataStream::Ok ||
+        magic != BinarySerializable::MAGIC ||
+        version > BinarySerializable::VERSION)
+    {
+        return false;
+    }
+    BinaryPalette palette;
+    palette.read(stream);
+    obj.readBinary(stream, palette);
+
+    return stream.status() == QDataStream::Ok;
+}
+
+// -------------------------------------------------------
+
+bool Wanok::copyPath(QString src, QString dst, QString excluded)
 {
     QDir dir(src);
     if (!dir.exists())
         return false;
 
     foreach (QString d, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (!excluded.isEmpty() && pathCombine(src, d) == excluded)
+            continue;
         QString dst_path = pathCombine(dst, d);
         if (!dir.mkpath(dst_path)) return false;
-        if (!copyPath(pathCombine(src, d), dst_path)) return false;
+        if (!copyPath(pathCombine(src, d), dst_path, excluded)) return false;
     }
 
     foreach (QString f, dir.entryList(QDir::Files)) {
@@ -28,6 +28,7 @@
 #include "map.h"
 #include "enginesettings.h"
 #include "oskind.h"
+#include "binaryserializable.h"
 
 // -------------------------------------------------------
 //
@@ -97,9 +98,12 @@ public:
     const static QString pathEngineSettings;
     const static QString fileMapInfos;
     const static QString fileMapObjects;
+    const static QString FILE_MAP_PACK;
+    const static QString FILE_MAP_JOURNAL;
     const static QString gamesFolderName;
     const static QString TEMP_MAP_FOLDER_NAME;
     const static QString TEMP_UNDOREDO_MAP_FOLDER_NAME;
+    const static QString EXTENSION_PORTION_BINARY;
     const static QString dirGames;
     const static QString dirDesktop;
 
@@ -117,7 +121,13 @@ public:
     static void readOtherJSON(QString path, QJsonDocument& loadDoc);
     static void writeArrayJSON(QString path, const QJsonArray &tab);
     static void readArrayJSON(QString path, QJsonDocument& loadDoc);
-    static bool copyPath(QString src, QString dst);
+    static void writeBinary(QString path, const BinarySerializable &obj);
+    static bool readBinary(QString path, BinarySerializable &obj);
+    static void writeBinaryData(QByteArray& data,
+                                const BinarySerializable &obj);
+    static bool readBinaryData(const QByteArray& data,
+                               BinarySerializable &obj);
+    static bool copyPath(QString src, QString dst, QString excluded = "");
     static QString getDirectoryPath(QString& file);
     static bool isDirEmpty(QString path);
     static void copyAllFiles(QString pathSource, QString pathTarget);
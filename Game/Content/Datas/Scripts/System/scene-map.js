@@ -156,7 +156,8 @@ SceneMap.prototype = {
             Wanok.openFile(this, Wanok.FILE_MAPS + this.mapName + "/" +
                            fileName, wait, function(res)
             {
-                var json = JSON.parse(res);
+                // Empty portions are not written in a file
+                var json = res ? JSON.parse(res) : {};
                 var mapPortion = null;
 
                 if (json.hasOwnProperty("floors")){
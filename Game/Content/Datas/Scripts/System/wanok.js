@@ -88,7 +88,9 @@ Wanok.openFile = function(base, url, loading, callback){
     doc.onreadystatechange = function() {
         if (doc.readyState === XMLHttpRequest.DONE) {
             try{
-                callback.call(base, doc.responseText);
+                // A missing file is given as an empty text
+                var text = doc.status === 404 ? "" : doc.responseText;
+                callback.call(base, text);
             }
             catch (e){
                 Wanok.showError(e);